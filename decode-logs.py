@@ -0,0 +1,161 @@
+#!/usr/bin/python
+
+from __future__ import print_function
+
+import struct
+import sys
+import re
+
+BINARY_LOG_FIELD = 1001
+BINARY_LOG_VERSION = 1
+LEVELS = [ "TRACE", "DEBUG", "INFO", "WARN", "ERROR" ]
+CONVERSION = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|L|z|j|t)?([diuxXocfFeEgGaAspn%])")
+
+class Elf:
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4:5] != b"\x01":
+            raise Exception("Expected a 32bit ELF")
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2e)
+        self.sections = []
+        for i in range(shnum):
+            fields = struct.unpack_from("<IIIIIIIIII", self.data, shoff + i * shentsize)
+            type, addr, offset, size = fields[1], fields[3], fields[4], fields[5]
+            # Skip NOBITS sections, they have no contents in the file.
+            if addr > 0 and type != 8:
+                self.sections.append((addr, offset, size))
+
+    def string(self, address):
+        for addr, offset, size in self.sections:
+            if addr <= address < addr + size:
+                start = offset + address - addr
+                end = self.data.index(b"\x00", start)
+                return self.data[start:end].decode("utf-8", "replace")
+        return "<0x%08x>" % address
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.position = 0
+
+    def remaining(self):
+        return len(self.data) - self.position
+
+    def take(self, size):
+        if size > self.remaining():
+            raise EOFError()
+        value = self.data[self.position:self.position + size]
+        self.position += size
+        return value
+
+    def u8(self):
+        return struct.unpack("<B", self.take(1))[0]
+
+    def u32(self):
+        return struct.unpack("<I", self.take(4))[0]
+
+    def u64(self):
+        return struct.unpack("<Q", self.take(8))[0]
+
+    def varint(self):
+        value = 0
+        shift = 0
+        while True:
+            b = self.u8()
+            value |= (b & 0x7f) << shift
+            shift += 7
+            if b & 0x80 == 0:
+                return value
+
+def signed(value, bits):
+    if value & (1 << (bits - 1)):
+        return value - (1 << bits)
+    return value
+
+def format_line(format, args):
+    def replace(m):
+        flags, width, precision, length, conversion = m.groups()
+        if conversion == "%":
+            return "%"
+        if width == "*":
+            width = str(signed(args.u32(), 32))
+        if precision == "*":
+            precision = str(signed(args.u32(), 32))
+        spec = "%" + flags + (width or "") + ("." + precision if precision is not None else "")
+        wide = length in ("ll", "j")
+        if conversion in "di":
+            value = signed(args.u64(), 64) if wide else signed(args.u32(), 32)
+            return (spec + "d") % value
+        if conversion in "uxXo":
+            value = args.u64() if wide else args.u32()
+            return (spec + ("d" if conversion == "u" else conversion)) % value
+        if conversion == "c":
+            return (spec + "c") % chr(args.u32() & 0xff)
+        if conversion in "fFeEgGaA":
+            value = struct.unpack("<d", struct.pack("<Q", args.u64()))[0]
+            return (spec + ("f" if conversion in "aAF" else conversion)) % value
+        if conversion == "s":
+            value = args.take(args.u8()).decode("utf-8", "replace")
+            return (spec + "s") % value
+        if conversion == "p":
+            return "0x%08x" % args.u32()
+        return ""
+    return CONVERSION.sub(replace, format)
+
+def decode_block(elf, block):
+    reader = Reader(block)
+    if reader.u8() != BINARY_LOG_VERSION:
+        print("Unknown binary log version")
+        return
+    dropped = reader.varint()
+    if dropped > 0:
+        print("(%d entries dropped)" % dropped)
+    while reader.remaining() > 0:
+        uptime = reader.u32()
+        time = reader.u32()
+        level = reader.u8()
+        facility = elf.string(reader.u32())
+        format = elf.string(reader.u32())
+        args = Reader(reader.take(reader.u8()))
+        try:
+            message = format_line(format, args)
+        except EOFError:
+            message = format + " <missing arguments>"
+        name = LEVELS[level] if level < len(LEVELS) else str(level)
+        print("%08d %d %-5s %s: %s" % (uptime, time, name, facility, message))
+
+def decode_file(elf, data):
+    reader = Reader(data)
+    others = 0
+    while reader.remaining() > 0:
+        record = Reader(reader.take(reader.varint()))
+        binary = False
+        while record.remaining() > 0:
+            tag = record.varint()
+            field, type = tag >> 3, tag & 7
+            if type == 0:
+                record.varint()
+            elif type == 1:
+                record.take(8)
+            elif type == 2:
+                value = record.take(record.varint())
+                if field == BINARY_LOG_FIELD:
+                    decode_block(elf, value)
+                    binary = True
+            elif type == 5:
+                record.take(4)
+            else:
+                raise Exception("Unexpected wire type %d" % type)
+        if not binary:
+            others += 1
+    if others > 0:
+        print("(%d formatted records skipped)" % others)
+
+if len(sys.argv) != 3:
+    print("Usage: decode-logs.py <fk-core.elf> <logs.fklog>")
+    sys.exit(2)
+
+with open(sys.argv[2], "rb") as f:
+    decode_file(Elf(sys.argv[1]), f.read())
@@ -7,8 +7,8 @@ namespace fk {
 int32_t Crc32Reader::read(uint8_t *ptr, size_t size) {
     auto bytes = target_->read(ptr, size);
 
-    for (auto i = 0; i < bytes; ++i) {
-        crc_ = crc32_update(crc_, *(ptr++));
+    if (bytes > 0) {
+        crc_ = crc32_update(crc_, ptr, bytes);
     }
 
     return bytes;
@@ -25,8 +25,8 @@ void Crc32Reader::close() {
 int32_t Crc32Writer::write(uint8_t *ptr, size_t size) {
     auto bytes = target_->write(ptr, size);
 
-    for (auto i = 0; i < bytes; ++i) {
-        crc_ = crc32_update(crc_, *(ptr++));
+    if (bytes > 0) {
+        crc_ = crc32_update(crc_, ptr, bytes);
     }
 
     return bytes;
@@ -6,8 +6,22 @@
 
 namespace fk {
 
+/**
+ * Bulk updates use the 16 entry table by default, which is the smallest.
+ * FK_CRC32_SLICE_BY_4 and FK_CRC32_SLICE_BY_8 select 4K and 8K tables that
+ * fold in four or eight bytes at a time, and FK_CRC32_DSU has the DSU of a
+ * SAMD21 or SAMD51 do runs of at least Crc32DsuMinimum bytes, anywhere else
+ * it's an error.
+ *
+ * Every variant produces the same values, the running value starts at ~0
+ * and is inverted once at the end.
+ */
+constexpr size_t Crc32DsuMinimum = 64;
+
 uint32_t crc32_update(uint32_t crc, uint8_t data);
 
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t size);
+
 uint32_t crc32_checksum(uint8_t *data, size_t size);
 
 }
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cstring>
 
 #include "file_reader.h"
 #include "debug.h"
@@ -23,7 +24,7 @@ bool FileReader::isOpen() {
 }
 
 bool FileReader::isFinished() {
-    return file_ != nullptr && done_;
+    return file_ != nullptr && done_ && buffered() == 0;
 }
 
 size_t FileReader::size() {
@@ -31,7 +32,7 @@ size_t FileReader::size() {
 }
 
 size_t FileReader::tell() {
-    return file_->tell();
+    return file_->tell() - buffered();
 }
 
 uint32_t FileReader::version() const {
@@ -39,6 +40,7 @@ uint32_t FileReader::version() const {
 }
 
 bool FileReader::seek(uint64_t position) {
+    discard();
     return file_->seek(position);
 }
 
@@ -51,6 +53,8 @@ bool FileReader::open(uint32_t offset, uint32_t length) {
     offset_ = offset;
     length_ = length;
 
+    discard();
+
     auto fileSize = file_->size();
 
     if (!file_->seek(offset_)) {
@@ -79,10 +83,115 @@ bool FileReader::open(uint32_t offset, uint32_t length) {
 }
 
 int32_t FileReader::read(uint8_t *ptr, size_t size) {
+    size_t copied = 0;
+
+    while (copied < size) {
+        if (consumed_ == filled_[front_]) {
+            auto back = 1 - front_;
+            if (filled_[back] == 0) {
+                break;
+            }
+            filled_[front_] = 0;
+            consumed_ = 0;
+            front_ = back;
+        }
+
+        auto n = std::min(filled_[front_] - consumed_, size - copied);
+        memcpy(ptr + copied, buffers_[front_] + consumed_, n);
+        consumed_ += n;
+        copied += n;
+    }
+
+    if (copied < size) {
+        auto read = readFile(ptr + copied, size - copied);
+        if (read > 0) {
+            copied += read;
+        }
+    }
+
+    if (copied == 0) {
+        return EOS;
+    }
+
+    return copied;
+}
+
+void FileReader::readAhead(Pool &pool, size_t size) {
+    buffers_[0] = (uint8_t *)pool.malloc(size);
+    buffers_[1] = (uint8_t *)pool.malloc(size);
+    bufferSize_ = size;
+    discard();
+}
+
+bool FileReader::prefetch() {
+    auto back = 1 - front_;
+    if (buffers_[back] == nullptr || filled_[back] > 0) {
+        return filled_[back] > 0;
+    }
+
+    // Until the front's been used there's nowhere to swap to, so fill that.
+    if (consumed_ == filled_[front_]) {
+        back = front_;
+        consumed_ = 0;
+    }
+
+    auto read = readFile(buffers_[back], bufferSize_);
+    if (read <= 0) {
+        return false;
+    }
+
+    filled_[back] = read;
+
+    return true;
+}
+
+int32_t FileReader::peek(uint8_t **ptr, size_t size) {
+    fk_assert(buffers_[0] != nullptr);
+
+    if (consumed_ == filled_[front_]) {
+        auto back = 1 - front_;
+        if (filled_[back] > 0) {
+            filled_[front_] = 0;
+            front_ = back;
+        }
+        else {
+            auto read = readFile(buffers_[front_], std::min(size, bufferSize_));
+            if (read <= 0) {
+                filled_[front_] = 0;
+                consumed_ = 0;
+                return EOS;
+            }
+            filled_[front_] = read;
+        }
+        consumed_ = 0;
+    }
+
+    *ptr = buffers_[front_] + consumed_;
+
+    return std::min(size, filled_[front_] - consumed_);
+}
+
+void FileReader::consume(size_t size) {
+    fk_assert(consumed_ + size <= filled_[front_]);
+    consumed_ += size;
+}
+
+size_t FileReader::buffered() const {
+    return (filled_[front_] - consumed_) + filled_[1 - front_];
+}
+
+void FileReader::discard() {
+    filled_[0] = 0;
+    filled_[1] = 0;
+    consumed_ = 0;
+    front_ = 0;
+}
+
+int32_t FileReader::readFile(uint8_t *ptr, size_t size) {
     auto position = 0;
     auto end = offset_ + length_;
     if (file_ != nullptr && !done_) {
-        auto left = end - tell();
+        auto left = end - file_->tell();
         auto remaining = std::min(size, (size_t)left);
         while (remaining > 0) {
             auto read = file_->read(ptr + position, remaining);
@@ -93,7 +202,7 @@ int32_t FileReader::read(uint8_t *ptr, size_t size) {
             position += read;
             remaining -= read;
         }
-        if (tell() == end) {
+        if (file_->tell() == end) {
             done_ = true;
         }
     }
@@ -4,8 +4,16 @@
 #include <lwstreams/lwstreams.h>
 #include <phylum/phylum.h>
 
+#include "pool.h"
+
 namespace fk {
 
+/**
+ * Reads a range of a file. With read ahead enabled the reader keeps two
+ * buffers, the one reads are served from and one prefetch fills, so the SD
+ * card can be read while we'd otherwise be waiting on whoever the data's
+ * going to.
+ */
 class FileReader : public lws::SizedReader {
 private:
     phylum::File *file_{ nullptr };
@@ -13,6 +21,11 @@ private:
     uint32_t length_{ 0 };
     bool opened_{ false };
     bool done_{ false };
+    uint8_t *buffers_[2]{ nullptr, nullptr };
+    size_t filled_[2]{ 0, 0 };
+    size_t bufferSize_{ 0 };
+    size_t consumed_{ 0 };
+    uint8_t front_{ 0 };
 
 public:
     FileReader();
@@ -33,6 +46,38 @@ public:
     bool isFinished();
     bool isOpen();
 
+    /**
+     * Enables read ahead with two buffers of size bytes from the pool, which
+     * has to last as long as the reader.
+     */
+    void readAhead(Pool &pool, size_t size);
+
+    /**
+     * Fills the spare buffer if it's empty, returns true if it has data.
+     */
+    bool prefetch();
+
+    /**
+     * Bytes read from the file that haven't been returned yet.
+     */
+    size_t buffered() const;
+
+    /**
+     * Points at up to size bytes that have been read ahead, reading more if
+     * there aren't any, so they can be written from where they are. Nothing
+     * is used up until consume. Needs read ahead.
+     */
+    int32_t peek(uint8_t **ptr, size_t size);
+
+    /**
+     * Uses up bytes returned by peek.
+     */
+    void consume(size_t size);
+
+private:
+    int32_t readFile(uint8_t *ptr, size_t size);
+    void discard();
+
 };
 
 }
@@ -20,6 +20,21 @@ bool MessageBuffer::write(const pb_msgdesc_t *fields, void *src) {
     return true;
 }
 
+bool MessageBuffer::append(const pb_msgdesc_t *fields, void *src, size_t maximum) {
+    auto limit = (maximum > 0 && maximum < size()) ? maximum : size();
+    if (pos >= limit) {
+        return false;
+    }
+
+    auto stream = pb_ostream_from_buffer(ptr() + pos, limit - pos);
+    if (!pb_encode_delimited(&stream, fields, src)) {
+        return false;
+    }
+    pos += stream.bytes_written;
+
+    return true;
+}
+
 bool MessageBuffer::read(const pb_msgdesc_t *fields, void *src) {
     fk_assert(pos > 0);
     auto stream = pb_istream_from_buffer(ptr(), pos);
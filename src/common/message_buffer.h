@@ -2,6 +2,7 @@
 #define FK_MESSAGE_BUFFER_H_INCLUDED
 
 #include "two_wire.h"
+#include "tuning.h"
 
 namespace fk {
 
@@ -24,6 +25,15 @@ public:
         return write(T::fields, message.forEncode());
     }
 
+    /**
+     * Encodes another message after the ones already in the buffer, failing
+     * if the buffer would grow beyond maximum bytes.
+     */
+    template<typename T>
+    bool append(T &message, size_t maximum = 0) {
+        return append(T::fields, message.forEncode(), maximum);
+    }
+
     size_t position() {
         return pos;
     }
@@ -51,6 +61,7 @@ public:
 
 private:
     bool write(const pb_msgdesc_t *fields, void *src);
+    bool append(const pb_msgdesc_t *fields, void *src, size_t maximum);
     bool read(const pb_msgdesc_t *fields, void *src);
 
 };
@@ -95,7 +106,7 @@ public:
 
 };
 
-class TwoWireMessageBuffer : public ArrayMessageBuffer<256> {
+class TwoWireMessageBuffer : public ArrayMessageBuffer<TwoWireMessageBufferSize> {
 private:
     TwoWireBus *bus;
 
@@ -8,6 +8,16 @@
 
 namespace fk {
 
+/**
+ * QUERY_READING_STATUS from cores that decode several replies from one
+ * transaction, modules pack every finished reading that fits into the reply.
+ * The module protocol doesn't have it yet, so it's numbered well past the
+ * protocol's own query types. Modules from before it answer REPLY_ERROR, as
+ * they do to any query they don't know, and are then sent
+ * QUERY_READING_STATUS, which always gets one reading.
+ */
+constexpr uint32_t QueryReadingStatusPacked = 100;
+
 class ModuleQueryMessage {
 public:
     static constexpr const pb_msgdesc_t *fields{ fk_module_WireMessageQuery_fields };
@@ -3,6 +3,7 @@
 
 #include <cinttypes>
 #include <cstdlib>
+#include <new>
 #include <type_traits>
 
 namespace fk {
@@ -40,6 +41,16 @@ public:
 
     void clear();
     void *malloc(size_t size);
+
+    /**
+     * Allocates and constructs a T. Nothing's ever destroyed, the memory's
+     * reused when the pool's cleared, so T can't own anything else.
+     */
+    template<typename T>
+    T *make() {
+        return new (malloc(sizeof(T))) T();
+    }
+
     void *copy(void *ptr, size_t size);
     char *strdup(const char *str);
     Pool freeze(const char *name);
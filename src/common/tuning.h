@@ -12,6 +12,14 @@ constexpr uint32_t Hours = 60 * Minutes;
 
 constexpr uint32_t TwoWireDefaultSpeed = 400000;
 
+/**
+ * Size of the buffers modules encode replies into and the core receives them
+ * in, SERIAL_BUFFER_SIZE. The largest reply the core reads in one transaction
+ * is a byte less, see TwoWireTask::receive.
+ */
+constexpr size_t TwoWireMessageBufferSize = 256;
+constexpr size_t TwoWireMaximumReplySize = TwoWireMessageBufferSize - 1;
+
 constexpr uint32_t PowerManagementQueryInterval = 30 * Seconds;
 constexpr uint32_t PowerManagementAlertInterval = 1 * Minutes;
 
@@ -36,11 +44,92 @@ constexpr uint32_t SleepMinimumSeconds = 5;
 constexpr uint32_t SleepLeadingWakeupSeconds = 5;
 
 constexpr uint32_t FileCopyBufferSize = 256;
+
+/**
+ * Most the core's file copies read from the SD card at a time, whole sectors
+ * so reads don't split them. The buffers are lent for the length of a copy,
+ * two to read ahead into that writes are made from, see FileCopyOperation.
+ */
+constexpr uint32_t FileCopyTransferSize = 2 * 512;
+constexpr size_t FileCopyPoolSize = 2 * FileCopyTransferSize;
+
 constexpr uint32_t FileCopyStatusInterval = 1 * Seconds;
-constexpr uint32_t FileCopyMaximumElapsed = 4 * Seconds;
+
+/**
+ * Bounds on how long a file copy runs before giving the loop a turn and how
+ * much it reads at a time, see copy_pacer.h. A write taking longer than
+ * FileCopyStallThreshold means the other end isn't keeping up.
+ */
+constexpr uint32_t FileCopyMaximumElapsed = 1 * Seconds;
+constexpr uint32_t FileCopyMinimumSlice = 50;
+constexpr uint32_t FileCopyMinimumChunk = 512;
+constexpr uint32_t FileCopyStallThreshold = 100;
+constexpr size_t FileCopyHistogramBuckets = 20;
 
 constexpr size_t FileSystemNumberOfFiles = 5;
 
+/**
+ * Log files are rotated through, the next is erased and opened ahead of time
+ * once the active one is within LogStandbyLeadBlocks of being full.
+ */
+constexpr size_t FileSystemNumberOfLogs = 2;
+constexpr uint32_t LogStandbyLeadBlocks = 4;
+
+/**
+ * Cursor deltas appended to the system file before another snapshot, which
+ * bounds how far back we read at boot. When a snapshot won't fit within
+ * FileCursorCompactLeadBlocks of the end it's appended into that space and
+ * then the file is erased and it's written again.
+ */
+constexpr uint32_t FileCursorDeltasPerSnapshot = 32;
+constexpr uint32_t FileCursorCompactLeadBlocks = 2;
+
+/**
+ * Smallest the data file grows to before it may be dropped once uploaded,
+ * each drop costs an erase and a cursor snapshot.
+ */
+constexpr uint32_t DataSegmentSize = 4 * 1024 * 1024;
+
+/**
+ * Entries in the in memory index of the data file and the initial number of
+ * bytes between them, the spacing doubles each time the index fills.
+ */
+constexpr size_t DataIndexSize = 32;
+constexpr uint32_t DataIndexStride = 4096;
+
+/**
+ * Limits on downsampled summaries of the data file, widths are in seconds.
+ */
+constexpr uint32_t DataSummaryMaximumBuckets = 512;
+constexpr uint32_t DataSummaryDefaultWidth = 60 * 60;
+constexpr size_t DataSummaryRecordMaximum = 256;
+
+/**
+ * RAM each of the data and log files stages appends in before they're written
+ * to the SD card, one sector.
+ */
+constexpr size_t StagedFileBufferSize = 512;
+
+/**
+ * Sectors of the SD card kept in RAM under the file system, see
+ * block_cache.h.
+ */
+constexpr size_t BlockCacheSectors = 4;
+
+/**
+ * Sectors read ahead or gathered for writing at a time by the block cache,
+ * each run is one request to the SD card rather than one per sector.
+ */
+constexpr size_t BlockCacheRunSectors = 4;
+
+/**
+ * RAM unformatted log entries are kept in, and when they're written out to
+ * the log file, see binary_log.h.
+ */
+constexpr size_t BinaryLogBufferSize = 512;
+constexpr size_t BinaryLogCommitSize = 256;
+constexpr uint32_t BinaryLogMaximumAge = 10 * Seconds;
+
 constexpr uint32_t ButtonTouchHysteresis = 100;
 constexpr uint32_t ButtonShortPressDuration = 2 * Seconds;
 constexpr uint32_t ButtonLongPressDuration = 5 * Seconds;
@@ -49,6 +138,18 @@ constexpr uint32_t SchedulerCheckInterval = 500;
 
 constexpr uint32_t SelfFlashWaitPeriod = 20 * Seconds;
 
+/**
+ * Number of readings a module sampling on its own schedule keeps for the
+ * core, oldest are dropped first.
+ */
+constexpr size_t ModuleReadingsBufferSize = 64;
+
+/**
+ * Oldest reading, in seconds, the core will accept a timestamp for. Buffered
+ * readings from modules that sample on their own are legitimately old.
+ */
+constexpr uint32_t BufferedReadingsMaximumAge = 24 * 60 * 60;
+
 // TODO: The following should be moved to friendly configuration area.
 
 constexpr uint32_t StatusInterval = 5 * Seconds;
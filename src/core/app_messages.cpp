@@ -75,30 +75,20 @@ fk_app_WireMessageReply *AppReplyMessage::forEncode() {
 }
 
 void AppReplyMessage::busy(const char *text) {
-    fk_app_Error errors[] = {
-        {
-            .message = {
-                .funcs = {
-                    .encode = pb_encode_string,
-                },
-                .arg = (void *)text,
-            },
-        }
-    };
-
-    pb_array_t errors_array = {
-        .length = sizeof(errors) / sizeof(fk_app_Error),
-        .itemSize = sizeof(fk_app_Error),
-        .buffer = pool->copy(errors, sizeof(errors)),
-        .fields = fk_app_Error_fields,
-    };
-
     message.type = fk_app_ReplyType_REPLY_BUSY;
-    message.errors.funcs.encode = pb_encode_array;
-    message.errors.arg = (void *)pool->copy(&errors_array, sizeof(errors_array));
+    errors(text);
 }
 
 void AppReplyMessage::error(const char *text) {
+    message.type = fk_app_ReplyType_REPLY_ERROR;
+    errors(text);
+}
+
+void AppReplyMessage::status(const char *text) {
+    errors(pool->strdup(text));
+}
+
+void AppReplyMessage::errors(const char *text) {
     fk_app_Error errors[] = {
         {
             .message = {
@@ -117,7 +107,6 @@ void AppReplyMessage::error(const char *text) {
         .fields = fk_app_Error_fields,
     };
 
-    message.type = fk_app_ReplyType_REPLY_ERROR;
     message.errors.funcs.encode = pb_encode_array;
     message.errors.arg = (void *)pool->copy(&errors_array, sizeof(errors_array));
 }
@@ -64,6 +64,15 @@ public:
     void busy(const char *text);
     void error(const char *text);
 
+    /**
+     * Adds text to the reply's errors without changing its type, for things
+     * the app should know that the reply has no field for. The text's copied.
+     */
+    void status(const char *text);
+
+private:
+    void errors(const char *text);
+
 };
 
 }
@@ -3,13 +3,13 @@
 namespace fk {
 
 AppModuleQueryTask::AppModuleQueryTask(AppReplyMessage &reply, AppQueryMessage &query, MessageBuffer &buffer, uint8_t address, ModuleCommunications &communications) :
-    Task("AppModuleQueryTask"), reply(&reply), query(&query), buffer(&buffer), customModuleQuery(reply, query, buffer), protocol(communications) {
+    Task("AppModuleQueryTask"), reply(&reply), query(&query), buffer(&buffer), customModuleQuery(reply, query, buffer), protocol(communications), address(address) {
 }
 
 void AppModuleQueryTask::enqueued() {
     fk_assert(peripherals.twoWire1().tryAcquire(this));
 
-    protocol.push(8, customModuleQuery);
+    protocol.push(address, customModuleQuery);
 }
 
 TaskEval AppModuleQueryTask::task() {
@@ -40,6 +40,7 @@ private:
     MessageBuffer *buffer;
     CustomModuleQuery customModuleQuery;
     ModuleProtocolHandler protocol;
+    uint8_t address;
 
 public:
     AppModuleQueryTask(AppReplyMessage &reply, AppQueryMessage &query, MessageBuffer &buffer, uint8_t address, ModuleCommunications &communications);
@@ -0,0 +1,253 @@
+#include <cstring>
+
+#include "binary_log.h"
+
+namespace fk {
+
+class ArgumentWriter {
+private:
+    uint8_t *buffer_;
+    size_t size_;
+    size_t position_{ 0 };
+    bool overflowed_{ false };
+
+public:
+    ArgumentWriter(uint8_t *buffer, size_t size) : buffer_(buffer), size_(size) {
+    }
+
+public:
+    void u8(uint8_t value) {
+        if (position_ == size_) {
+            overflowed_ = true;
+            return;
+        }
+        buffer_[position_++] = value;
+    }
+
+    void u32(uint32_t value) {
+        for (auto i = 0; i < 4; ++i) {
+            u8((uint8_t)(value >> (i * 8)));
+        }
+    }
+
+    void u64(uint64_t value) {
+        for (auto i = 0; i < 8; ++i) {
+            u8((uint8_t)(value >> (i * 8)));
+        }
+    }
+
+    void string(const char *value) {
+        if (value == nullptr) {
+            value = "(null)";
+        }
+        auto length = strlen(value);
+        if (length > BinaryLogMaximumString) {
+            length = BinaryLogMaximumString;
+        }
+        u8((uint8_t)length);
+        for (size_t i = 0; i < length; ++i) {
+            u8((uint8_t)value[i]);
+        }
+    }
+
+    size_t position() const {
+        return position_;
+    }
+
+    bool overflowed() const {
+        return overflowed_;
+    }
+
+};
+
+static size_t varint_size(uint32_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+static size_t varint_write(uint8_t *ptr, uint32_t value) {
+    size_t size = 0;
+    while (value >= 0x80) {
+        ptr[size++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    ptr[size++] = (uint8_t)value;
+    return size;
+}
+
+int32_t binary_log_arguments(uint8_t *buffer, size_t size, const char *f, va_list args) {
+    ArgumentWriter writer{ buffer, size };
+
+    while (*f != 0) {
+        if (*f++ != '%') {
+            continue;
+        }
+
+        if (*f == '%') {
+            f++;
+            continue;
+        }
+
+        while (*f == '-' || *f == '+' || *f == ' ' || *f == '#' || *f == '0') {
+            f++;
+        }
+
+        if (*f == '*') {
+            writer.u32((uint32_t)va_arg(args, int));
+            f++;
+        }
+        while (*f >= '0' && *f <= '9') {
+            f++;
+        }
+
+        if (*f == '.') {
+            f++;
+            if (*f == '*') {
+                writer.u32((uint32_t)va_arg(args, int));
+                f++;
+            }
+            while (*f >= '0' && *f <= '9') {
+                f++;
+            }
+        }
+
+        auto longs = 0;
+        while (*f == 'h' || *f == 'l' || *f == 'L' || *f == 'z' || *f == 'j' || *f == 't') {
+            if (*f == 'l') {
+                longs++;
+            }
+            if (*f == 'j') {
+                longs = 2;
+            }
+            f++;
+        }
+
+        switch (*f) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': {
+            if (longs >= 2) {
+                writer.u64((uint64_t)va_arg(args, long long));
+            }
+            else if (longs == 1) {
+                writer.u32((uint32_t)va_arg(args, long));
+            }
+            else {
+                writer.u32((uint32_t)va_arg(args, int));
+            }
+            break;
+        }
+        case 'c': {
+            writer.u32((uint32_t)va_arg(args, int));
+            break;
+        }
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+            auto value = va_arg(args, double);
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            writer.u64(bits);
+            break;
+        }
+        case 's': {
+            writer.string(va_arg(args, const char *));
+            break;
+        }
+        case 'p': {
+            writer.u32((uint32_t)(uintptr_t)va_arg(args, void *));
+            break;
+        }
+        case 'n': {
+            va_arg(args, int *);
+            break;
+        }
+        case 0: {
+            return writer.overflowed() ? -1 : (int32_t)writer.position();
+        }
+        default: {
+            break;
+        }
+        }
+
+        f++;
+    }
+
+    if (writer.overflowed()) {
+        return -1;
+    }
+
+    return writer.position();
+}
+
+bool BinaryLog::append(uint32_t uptime, uint32_t time, uint8_t level, const char *facility, const char *f, va_list args) {
+    constexpr size_t EntryHeaderSize = 4 + 4 + 1 + 4 + 4 + 1;
+
+    auto available = sizeof(buffer_) - position_;
+    if (available <= EntryHeaderSize) {
+        dropped_++;
+        return false;
+    }
+
+    auto arguments = available - EntryHeaderSize;
+    if (arguments > BinaryLogMaximumArguments) {
+        arguments = BinaryLogMaximumArguments;
+    }
+
+    va_list copy;
+    va_copy(copy, args);
+    auto size = binary_log_arguments(buffer_ + position_ + EntryHeaderSize, arguments, f, copy);
+    va_end(copy);
+
+    if (size < 0) {
+        dropped_++;
+        return false;
+    }
+
+    ArgumentWriter header{ buffer_ + position_, EntryHeaderSize };
+    header.u32(uptime);
+    header.u32(time);
+    header.u8(level);
+    header.u32((uint32_t)(uintptr_t)facility);
+    header.u32((uint32_t)(uintptr_t)f);
+    header.u8((uint8_t)size);
+
+    if (entries_ == 0) {
+        oldest_ = uptime;
+    }
+
+    position_ += EntryHeaderSize + size;
+    entries_++;
+
+    return true;
+}
+
+uint8_t *BinaryLog::record(size_t &size) {
+    auto entries = position_ - HeaderReserve;
+    auto blockSize = 1 + varint_size(dropped_) + entries;
+    auto tag = (BinaryLogField << 3) | 2;
+    auto bodySize = varint_size(tag) + varint_size(blockSize) + blockSize;
+
+    uint8_t header[HeaderReserve];
+    auto n = varint_write(header, bodySize);
+    n += varint_write(header + n, tag);
+    n += varint_write(header + n, blockSize);
+    header[n++] = BinaryLogVersion;
+    n += varint_write(header + n, dropped_);
+
+    auto begin = buffer_ + HeaderReserve - n;
+    memcpy(begin, header, n);
+
+    size = n + entries;
+
+    return begin;
+}
+
+void BinaryLog::clear() {
+    position_ = HeaderReserve;
+    entries_ = 0;
+    dropped_ = 0;
+    oldest_ = 0;
+}
+
+}
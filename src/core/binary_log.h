@@ -0,0 +1,101 @@
+#ifndef FK_BINARY_LOG_H_INCLUDED
+#define FK_BINARY_LOG_H_INCLUDED
+
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdlib>
+
+#include "tuning.h"
+
+namespace fk {
+
+/**
+ * Log lines kept unformatted, as the addresses of their facility and format
+ * strings and the raw bytes of their arguments, to be formatted later on a
+ * host with the firmware's ELF. Entries are written to the log file as a
+ * delimited DataRecord whose only field is BinaryLogField, which readers that
+ * don't know about it skip.
+ *
+ * Block layout:
+ *
+ *   version    u8, BinaryLogVersion
+ *   dropped    varint, entries dropped since the previous block
+ *   entries    until the end of the block
+ *
+ * Entries:
+ *
+ *   uptime     u32
+ *   time       u32
+ *   level      u8
+ *   facility   u32, address of the facility string
+ *   format     u32, address of the format string
+ *   size       u8, bytes of arguments that follow
+ *   arguments  one per conversion in the format, and per * width or
+ *              precision, in order. 4 bytes for integers, characters and
+ *              pointers, 8 for long longs and doubles, strings are a u8
+ *              length followed by at most BinaryLogMaximumString bytes.
+ *
+ * All little endian.
+ */
+constexpr uint32_t BinaryLogField = 1001;
+constexpr uint8_t BinaryLogVersion = 1;
+constexpr size_t BinaryLogMaximumString = 48;
+constexpr size_t BinaryLogMaximumArguments = 255;
+
+/**
+ * Encodes the arguments of a printf style format, returns the number of bytes
+ * written or -1 if they didn't fit.
+ */
+int32_t binary_log_arguments(uint8_t *buffer, size_t size, const char *f, va_list args);
+
+class BinaryLog {
+private:
+    static constexpr size_t HeaderReserve = 16;
+
+    uint8_t buffer_[HeaderReserve + BinaryLogBufferSize];
+    size_t position_{ HeaderReserve };
+    uint32_t oldest_{ 0 };
+    uint32_t entries_{ 0 };
+    uint32_t dropped_{ 0 };
+
+public:
+    /**
+     * Appends an entry, dropping it if there's no room left.
+     */
+    bool append(uint32_t uptime, uint32_t time, uint8_t level, const char *facility, const char *f, va_list args);
+
+    /**
+     * Finishes the entries so far as a complete record, returning where it
+     * begins and its size in bytes. The record stays valid until clear.
+     */
+    uint8_t *record(size_t &size);
+
+    /**
+     * Forgets the entries, after the record's been written.
+     */
+    void clear();
+
+    size_t size() const {
+        return position_ - HeaderReserve;
+    }
+
+    uint32_t entries() const {
+        return entries_;
+    }
+
+    uint32_t dropped() const {
+        return dropped_;
+    }
+
+    /**
+     * Uptime of the oldest entry that's waiting.
+     */
+    uint32_t oldest() const {
+        return oldest_;
+    }
+
+};
+
+}
+
+#endif
@@ -0,0 +1,492 @@
+#ifndef FK_BLOCK_CACHE_H_INCLUDED
+#define FK_BLOCK_CACHE_H_INCLUDED
+
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
+#include "pool.h"
+
+namespace fk {
+
+/**
+ * Whatever the cache sits in front of, positions are byte offsets into the
+ * block.
+ */
+class BlockCacheStorage {
+public:
+    virtual bool read(uint32_t block, uint32_t position, void *d, size_t n) = 0;
+    virtual bool write(uint32_t block, uint32_t position, const void *d, size_t n) = 0;
+
+};
+
+struct BlockCacheStatistics {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t bypassed;
+    uint32_t evictions;
+    uint32_t writebacks;
+    uint32_t batched;
+    uint32_t runs;
+};
+
+/**
+ * Keeps the N most recently used sectors in RAM taken from a pool. Small
+ * reads, which is what superblocks, file heads and the other metadata the
+ * file system rereads look like, are served from here. Reads and writes of
+ * whole uncached sectors go straight through so bulk transfers don't flush
+ * everything useful out.
+ *
+ * Writes are written through unless write back is enabled, then sectors are
+ * only written when they're evicted or on flush.
+ *
+ * With R run sectors, whole sectors that follow on from the previous bulk
+ * read are read ahead R at a time, and consecutive whole sector writes are
+ * gathered and written together when the run's full, something else needs
+ * the card or on flush. Runs never cross blocks, so they need to know how
+ * many sectors there are in one.
+ */
+template<size_t N, size_t R = 0>
+class BlockCache {
+private:
+    struct Entry {
+        uint32_t block;
+        uint32_t sector;
+        uint32_t used;
+        bool valid;
+        bool dirty;
+    };
+
+private:
+    BlockCacheStorage *storage_;
+    size_t sectorSize_;
+    uint8_t *data_{ nullptr };
+    Entry entries_[N];
+    uint32_t clock_{ 0 };
+    bool writeBack_{ false };
+    uint8_t *run_{ nullptr };
+    uint32_t runBlock_{ 0 };
+    uint32_t runSector_{ 0 };
+    uint32_t runSectors_{ 0 };
+    bool runDirty_{ false };
+    uint32_t sectorsPerBlock_{ 0 };
+    uint32_t lastBlock_{ 0 };
+    uint32_t lastSector_{ 0 };
+    bool sequential_{ false };
+    BlockCacheStatistics statistics_{ 0, 0, 0, 0, 0, 0, 0 };
+
+public:
+    BlockCache(BlockCacheStorage &storage, Pool &pool, size_t sectorSize) : storage_(&storage), sectorSize_(sectorSize) {
+        data_ = (uint8_t *)pool.malloc(N * sectorSize);
+        if (R > 0) {
+            run_ = (uint8_t *)pool.malloc(R * sectorSize);
+        }
+        invalidate();
+    }
+
+public:
+    void writeBack(bool enabled) {
+        writeBack_ = enabled;
+    }
+
+    /**
+     * Until this is known nothing's read ahead or gathered.
+     */
+    void sectorsPerBlock(uint32_t sectors) {
+        sectorsPerBlock_ = sectors;
+    }
+
+    bool read(uint32_t block, uint32_t position, void *d, size_t n) {
+        if (data_ == nullptr) {
+            return storage_->read(block, position, d, n);
+        }
+
+        if (n >= sectorSize_ && !cached(block, position, n)) {
+            statistics_.bypassed++;
+            return bulk(block, position, d, n);
+        }
+
+        auto ptr = (uint8_t *)d;
+        while (n > 0) {
+            auto sector = position / sectorSize_;
+            auto offset = position % sectorSize_;
+            auto chunk = sectorSize_ - offset < n ? sectorSize_ - offset : n;
+
+            auto entry = find(block, sector);
+            if (entry != nullptr) {
+                statistics_.hits++;
+            }
+            else {
+                statistics_.misses++;
+                entry = fill(block, sector);
+                if (entry == nullptr) {
+                    return false;
+                }
+            }
+
+            memcpy(ptr, sectorOf(entry) + offset, chunk);
+
+            ptr += chunk;
+            position += chunk;
+            n -= chunk;
+        }
+
+        return true;
+    }
+
+    bool write(uint32_t block, uint32_t position, const void *d, size_t n) {
+        if (data_ == nullptr) {
+            return storage_->write(block, position, d, n);
+        }
+
+        written(block, position, n);
+
+        if (!writeBack_) {
+            if (batching() && position % sectorSize_ == 0 && n % sectorSize_ == 0) {
+                if (!gather(block, position, (const uint8_t *)d, n)) {
+                    return false;
+                }
+            }
+            else {
+                if (overlaps(block, position, n) && !flushRun()) {
+                    return false;
+                }
+                if (!storage_->write(block, position, d, n)) {
+                    return false;
+                }
+            }
+        }
+
+        auto ptr = (const uint8_t *)d;
+        while (n > 0) {
+            auto sector = position / sectorSize_;
+            auto offset = position % sectorSize_;
+            auto chunk = sectorSize_ - offset < n ? sectorSize_ - offset : n;
+
+            auto entry = find(block, sector);
+            if (entry == nullptr && writeBack_) {
+                entry = chunk == sectorSize_ ? allocate(block, sector) : fill(block, sector);
+                if (entry == nullptr) {
+                    return false;
+                }
+            }
+
+            if (entry != nullptr) {
+                memcpy(sectorOf(entry) + offset, ptr, chunk);
+                entry->dirty = writeBack_;
+            }
+
+            ptr += chunk;
+            position += chunk;
+            n -= chunk;
+        }
+
+        return true;
+    }
+
+    /**
+     * Forgets the block's sectors, including unwritten ones, for when the
+     * block is erased.
+     */
+    void erased(uint32_t block) {
+        if (runSectors_ > 0 && runBlock_ == block) {
+            dropRun();
+        }
+        for (auto &entry : entries_) {
+            if (entry.valid && entry.block == block) {
+                entry.valid = false;
+                entry.dirty = false;
+            }
+        }
+    }
+
+    /**
+     * Writes every dirty sector.
+     */
+    bool flush() {
+        auto success = flushRun();
+        for (auto &entry : entries_) {
+            if (!clean(&entry)) {
+                success = false;
+            }
+        }
+        return success;
+    }
+
+    void invalidate() {
+        for (auto &entry : entries_) {
+            entry = Entry{ 0, 0, 0, false, false };
+        }
+        dropRun();
+        sequential_ = false;
+    }
+
+    size_t dirty() const {
+        size_t number = 0;
+        for (auto &entry : entries_) {
+            if (entry.valid && entry.dirty) {
+                number++;
+            }
+        }
+        return number;
+    }
+
+    const BlockCacheStatistics &statistics() const {
+        return statistics_;
+    }
+
+private:
+    uint8_t *sectorOf(Entry *entry) {
+        return data_ + (entry - entries_) * sectorSize_;
+    }
+
+    Entry *find(uint32_t block, uint32_t sector) {
+        for (auto &entry : entries_) {
+            if (entry.valid && entry.block == block && entry.sector == sector) {
+                entry.used = ++clock_;
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    bool cached(uint32_t block, uint32_t position, size_t n) const {
+        auto first = position / sectorSize_;
+        auto last = (position + n - 1) / sectorSize_;
+        for (auto &entry : entries_) {
+            if (entry.valid && entry.block == block && entry.sector >= first && entry.sector <= last) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool clean(Entry *entry) {
+        if (!entry->valid || !entry->dirty) {
+            return true;
+        }
+        written(entry->block, entry->sector * sectorSize_, sectorSize_);
+        if (overlaps(entry->block, entry->sector * sectorSize_, sectorSize_) && !flushRun()) {
+            return false;
+        }
+        statistics_.writebacks++;
+        if (!storage_->write(entry->block, entry->sector * sectorSize_, sectorOf(entry), sectorSize_)) {
+            return false;
+        }
+        entry->dirty = false;
+        return true;
+    }
+
+    Entry *allocate(uint32_t block, uint32_t sector) {
+        Entry *victim = &entries_[0];
+        for (auto &entry : entries_) {
+            if (!entry.valid) {
+                victim = &entry;
+                break;
+            }
+            if (entry.used < victim->used) {
+                victim = &entry;
+            }
+        }
+
+        if (victim->valid) {
+            statistics_.evictions++;
+            if (!clean(victim)) {
+                return nullptr;
+            }
+        }
+
+        *victim = Entry{ block, sector, ++clock_, true, false };
+
+        return victim;
+    }
+
+    Entry *fill(uint32_t block, uint32_t sector) {
+        auto entry = allocate(block, sector);
+        if (entry == nullptr) {
+            return nullptr;
+        }
+        if (inRun(block, sector)) {
+            memcpy(sectorOf(entry), runOf(sector), sectorSize_);
+            return entry;
+        }
+        if (!storage_->read(block, sector * sectorSize_, sectorOf(entry), sectorSize_)) {
+            entry->valid = false;
+            return nullptr;
+        }
+        return entry;
+    }
+
+    bool batching() const {
+        return run_ != nullptr && sectorsPerBlock_ > 0;
+    }
+
+    uint8_t *runOf(uint32_t sector) {
+        return run_ + (sector - runSector_) * sectorSize_;
+    }
+
+    bool inRun(uint32_t block, uint32_t sector) const {
+        return runSectors_ > 0 && runBlock_ == block && sector >= runSector_ && sector < runSector_ + runSectors_;
+    }
+
+    bool overlaps(uint32_t block, uint32_t position, size_t n) const {
+        if (runSectors_ == 0 || runBlock_ != block) {
+            return false;
+        }
+        auto first = position / sectorSize_;
+        auto last = (position + n - 1) / sectorSize_;
+        return first < runSector_ + runSectors_ && last >= runSector_;
+    }
+
+    /**
+     * Sectors read ahead are stale once they've been written some other
+     * way, gathered ones are the newest there are.
+     */
+    void written(uint32_t block, uint32_t position, size_t n) {
+        if (!runDirty_ && overlaps(block, position, n)) {
+            dropRun();
+        }
+    }
+
+    void dropRun() {
+        runSectors_ = 0;
+        runDirty_ = false;
+    }
+
+    bool flushRun() {
+        if (!runDirty_ || runSectors_ == 0) {
+            return true;
+        }
+
+        statistics_.runs++;
+        if (!storage_->write(runBlock_, runSector_ * sectorSize_, run_, runSectors_ * sectorSize_)) {
+            dropRun();
+            return false;
+        }
+
+        // Still matches the card, so it's kept for reading.
+        runDirty_ = false;
+
+        return true;
+    }
+
+    /**
+     * Whole sector reads that aren't cached. Anything following on from
+     * the last one is read ahead, the rest go straight through.
+     */
+    bool bulk(uint32_t block, uint32_t position, void *d, size_t n) {
+        if (!batching() || position % sectorSize_ != 0 || n % sectorSize_ != 0) {
+            if (overlaps(block, position, n) && !flushRun()) {
+                return false;
+            }
+            return storage_->read(block, position, d, n);
+        }
+
+        auto ptr = (uint8_t *)d;
+        while (n > 0) {
+            auto sector = position / sectorSize_;
+
+            if (!inRun(block, sector)) {
+                if (!sequential_ || lastBlock_ != block || lastSector_ + 1 != sector || sector >= sectorsPerBlock_) {
+                    if (overlaps(block, position, n) && !flushRun()) {
+                        return false;
+                    }
+                    if (!storage_->read(block, position, ptr, n)) {
+                        return false;
+                    }
+                    remember(block, (position + n) / sectorSize_ - 1);
+                    return true;
+                }
+
+                if (!readRun(block, sector)) {
+                    return false;
+                }
+            }
+
+            memcpy(ptr, runOf(sector), sectorSize_);
+            statistics_.batched++;
+            remember(block, sector);
+
+            ptr += sectorSize_;
+            position += sectorSize_;
+            n -= sectorSize_;
+        }
+
+        return true;
+    }
+
+    bool readRun(uint32_t block, uint32_t sector) {
+        if (!flushRun()) {
+            return false;
+        }
+
+        auto sectors = sectorsPerBlock_ - sector < R ? sectorsPerBlock_ - sector : R;
+
+        statistics_.runs++;
+        if (!storage_->read(block, sector * sectorSize_, run_, sectors * sectorSize_)) {
+            dropRun();
+            return false;
+        }
+
+        runBlock_ = block;
+        runSector_ = sector;
+        runSectors_ = sectors;
+        runDirty_ = false;
+
+        return true;
+    }
+
+    void remember(uint32_t block, uint32_t sector) {
+        lastBlock_ = block;
+        lastSector_ = sector;
+        sequential_ = true;
+    }
+
+    /**
+     * Whole sector writes, added to the run if they follow on from it,
+     * otherwise the run's written and a new one started.
+     */
+    bool gather(uint32_t block, uint32_t position, const uint8_t *ptr, size_t n) {
+        while (n > 0) {
+            auto sector = position / sectorSize_;
+
+            if (runDirty_ && inRun(block, sector)) {
+                memcpy(runOf(sector), ptr, sectorSize_);
+            }
+            else {
+                auto follows = runDirty_ && runBlock_ == block && runSector_ + runSectors_ == sector && runSectors_ < R;
+                if (!follows) {
+                    if (!flushRun()) {
+                        return false;
+                    }
+                    runBlock_ = block;
+                    runSector_ = sector;
+                    runSectors_ = 0;
+                    runDirty_ = true;
+                }
+
+                memcpy(run_ + runSectors_ * sectorSize_, ptr, sectorSize_);
+                runSectors_++;
+            }
+
+            statistics_.batched++;
+
+            if (runSectors_ == R || runSector_ + runSectors_ == sectorsPerBlock_) {
+                if (!flushRun()) {
+                    return false;
+                }
+            }
+
+            ptr += sectorSize_;
+            position += sectorSize_;
+            n -= sectorSize_;
+        }
+
+        return true;
+    }
+
+};
+
+}
+
+#endif
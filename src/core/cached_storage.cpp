@@ -0,0 +1,64 @@
+#include "cached_storage.h"
+#include "configuration.h"
+
+using namespace phylum;
+
+namespace fk {
+
+CachedStorageBackend::CachedStorageBackend(ArduinoSdBackend &sd) : sd_(&sd) {
+}
+
+bool CachedStorageBackend::initialize(Geometry geometry, uint8_t cs) {
+    cache_.invalidate();
+    cache_.writeBack(configuration.storage.cache_write_back);
+    cache_.sectorsPerBlock(geometry.pages_per_block * geometry.sectors_per_page);
+    return sd_->initialize(geometry, cs);
+}
+
+bool CachedStorageBackend::open() {
+    return sd_->open();
+}
+
+bool CachedStorageBackend::close() {
+    auto success = cache_.flush();
+    cache_.invalidate();
+    if (!sd_->close()) {
+        return false;
+    }
+    return success;
+}
+
+Geometry &CachedStorageBackend::geometry() {
+    return sd_->geometry();
+}
+
+size_t CachedStorageBackend::size() {
+    return sd_->size();
+}
+
+bool CachedStorageBackend::erase(block_index_t block) {
+    cache_.erased(block);
+    return sd_->erase(block);
+}
+
+bool CachedStorageBackend::read(BlockAddress addr, void *d, size_t n) {
+    return cache_.read(addr.block, addr.position, d, n);
+}
+
+bool CachedStorageBackend::write(BlockAddress addr, void *d, size_t n) {
+    return cache_.write(addr.block, addr.position, d, n);
+}
+
+bool CachedStorageBackend::flush() {
+    return cache_.flush();
+}
+
+bool CachedStorageBackend::read(uint32_t block, uint32_t position, void *d, size_t n) {
+    return sd_->read(BlockAddress{ block, position }, d, n);
+}
+
+bool CachedStorageBackend::write(uint32_t block, uint32_t position, const void *d, size_t n) {
+    return sd_->write(BlockAddress{ block, position }, const_cast<void *>(d), n);
+}
+
+}
@@ -0,0 +1,52 @@
+#ifndef FK_CACHED_STORAGE_H_INCLUDED
+#define FK_CACHED_STORAGE_H_INCLUDED
+
+#include <phylum/phylum.h>
+#include <backends/arduino_sd/arduino_sd.h>
+
+#include "block_cache.h"
+#include "tuning.h"
+
+namespace fk {
+
+/**
+ * Puts a BlockCache between the file layout and the SD card. Erases go
+ * straight to the card after dropping the block's cached sectors. The file
+ * layout reads and writes a sector at a time, the cache's runs turn
+ * sequential ones into a single request to the card for several.
+ */
+class CachedStorageBackend : public phylum::StorageBackend, BlockCacheStorage {
+private:
+    phylum::ArduinoSdBackend *sd_;
+    StaticPool<(BlockCacheSectors + BlockCacheRunSectors) * phylum::SectorSize> pool_{ "BlockCache" };
+    BlockCache<BlockCacheSectors, BlockCacheRunSectors> cache_{ *this, pool_, phylum::SectorSize };
+
+public:
+    CachedStorageBackend(phylum::ArduinoSdBackend &sd);
+
+public:
+    bool initialize(phylum::Geometry geometry, uint8_t cs);
+    bool open() override;
+    bool close() override;
+    phylum::Geometry &geometry() override;
+    size_t size() override;
+    bool erase(phylum::block_index_t block) override;
+    bool read(phylum::BlockAddress addr, void *d, size_t n) override;
+    bool write(phylum::BlockAddress addr, void *d, size_t n) override;
+
+public:
+    bool flush();
+
+    BlockCache<BlockCacheSectors, BlockCacheRunSectors> &cache() {
+        return cache_;
+    }
+
+private:
+    bool read(uint32_t block, uint32_t position, void *d, size_t n) override;
+    bool write(uint32_t block, uint32_t position, const void *d, size_t n) override;
+
+};
+
+}
+
+#endif
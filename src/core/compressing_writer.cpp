@@ -0,0 +1,40 @@
+#include "compressing_writer.h"
+#include "debug.h"
+
+namespace fk {
+
+void CompressingWriter::begin(lws::Writer &target) {
+    target_ = &target;
+    encoder_.begin(*this);
+}
+
+int32_t CompressingWriter::write(uint8_t *ptr, size_t size) {
+    if (!encoder_.write(ptr, size)) {
+        return Stream::EOS;
+    }
+    return size;
+}
+
+int32_t CompressingWriter::write(uint8_t byte) {
+    return write(&byte, 1);
+}
+
+void CompressingWriter::close() {
+    finish();
+}
+
+bool CompressingWriter::finish() {
+    return encoder_.finish();
+}
+
+void CompressingWriter::status() {
+    auto &s = encoder_.statistics();
+    auto ratio = s.in > 0 ? (float)s.out / s.in : 0.0f;
+    logtracef("Lzss", "%lu -> %lu bytes (%.2f) (%lu literals, %lu matches)", s.in, s.out, ratio, s.literals, s.matches);
+}
+
+bool CompressingWriter::write(const uint8_t *ptr, size_t size) {
+    return target_->write(const_cast<uint8_t *>(ptr), size) == (int32_t)size;
+}
+
+}
@@ -0,0 +1,45 @@
+#ifndef FK_COMPRESSING_WRITER_H_INCLUDED
+#define FK_COMPRESSING_WRITER_H_INCLUDED
+
+#include <lwstreams/lwstreams.h>
+
+#include "lzss.h"
+
+namespace fk {
+
+/**
+ * Compresses what's written to it into another writer, see lzss.h. Groups
+ * are small so the target should be buffered, as BufferedWifiWriter is.
+ * Nothing is complete until finish, closing finishes.
+ */
+class CompressingWriter : public lws::Writer, LzssOutput {
+private:
+    lws::Writer *target_{ nullptr };
+    LzssEncoder encoder_;
+
+public:
+    void begin(lws::Writer &target);
+
+    int32_t write(uint8_t *ptr, size_t size) override;
+    int32_t write(uint8_t byte) override;
+    void close() override;
+
+    bool finish();
+
+    const LzssStatistics &statistics() const {
+        return encoder_.statistics();
+    }
+
+    /**
+     * Logs bytes in and out and the ratio between them.
+     */
+    void status();
+
+private:
+    bool write(const uint8_t *ptr, size_t size) override;
+
+};
+
+}
+
+#endif
@@ -39,6 +39,16 @@ struct Configuration {
          *
          */
         const char firmware_url[128] = FK_API_BASE "/devices/%s/%s/firmware";
+
+        /**
+         * Compress uploads, see lzss.h, which are then sent chunked as their
+         * size isn't known ahead of time. Only for servers that decode them.
+         */
+        #if defined(FK_WIFI_COMPRESS_UPLOADS)
+        bool compress_uploads{ true };
+        #else
+        bool compress_uploads{ false };
+        #endif
     };
 
     struct Gps {
@@ -113,6 +123,100 @@ struct Configuration {
 
     struct Logging {
         bool discovery{ true };
+
+        /**
+         * Log lines go to the log file unformatted, see binary_log.h.
+         */
+        #if defined(FK_LOGGING_BINARY)
+        bool binary{ true };
+        #else
+        bool binary{ false };
+        #endif
+    };
+
+    struct Data {
+        /**
+         * Write each gather's readings as compact reading blocks rather than
+         * a DataRecord per reading, see reading_block.h.
+         */
+        #if defined(FK_DATA_READING_BLOCKS)
+        bool reading_blocks{ true };
+        #else
+        bool reading_blocks{ false };
+        #endif
+
+        /**
+         * Decimal digits reading block values are quantized to.
+         */
+        uint8_t precision{ 3 };
+    };
+
+    struct Storage {
+        /**
+         * Staged appends to the data and log files are committed once this
+         * many bytes have built up, zero writes every append through.
+         */
+        #if defined(FK_STORAGE_WRITE_THROUGH)
+        uint32_t commit_bytes{ 0 };
+        #else
+        uint32_t commit_bytes{ StagedFileBufferSize };
+        #endif
+
+        /**
+         * Longest appends are left staged before being committed.
+         */
+        uint32_t commit_interval{ 30 * Seconds };
+
+        /**
+         * Commit after taking readings, before sleeping and before the WiFi
+         * comes up. Power downs and reboots always commit. Committing after
+         * readings still leaves a whole gather as a single write.
+         */
+        bool commit_after_readings{ true };
+        bool commit_before_sleep{ true };
+        bool commit_before_wifi{ true };
+
+        /**
+         * Sectors in the block cache are only written to the SD card when
+         * they're evicted or the file system is flushed, rather than as
+         * they're written.
+         */
+        #if defined(FK_STORAGE_CACHE_WRITE_BACK)
+        bool cache_write_back{ true };
+        #else
+        bool cache_write_back{ false };
+        #endif
+
+        /**
+         * Drop the data file once uploads have acknowledged all of it and
+         * it's grown past DataSegmentSize, see FileSystem::dropUploaded.
+         * Off unless asked for, the erase happens while uploading.
+         */
+        #if defined(FK_STORAGE_DROP_UPLOADED)
+        bool drop_uploaded{ true };
+        #else
+        bool drop_uploaded{ false };
+        #endif
+
+        /**
+         * Precede each record in the data and log files with a frame
+         * carrying its size and CRC, see record_frame.h.
+         */
+        #if defined(FK_STORAGE_FRAMED_RECORDS)
+        bool framed_records{ true };
+        #else
+        bool framed_records{ false };
+        #endif
+
+        /**
+         * Check the file sizes and versions QUERY_FILES is answered from
+         * against the file system, logging any that have gone stale.
+         */
+        #if defined(FK_STORAGE_VALIDATE_STATS)
+        bool validate_file_stats{ true };
+        #else
+        bool validate_file_stats{ false };
+        #endif
     };
 
     Wifi wifi;
@@ -121,6 +225,8 @@ struct Configuration {
     Sleeping sleeping;
     CommonConfiguration common;
     Logging logging;
+    Data data;
+    Storage storage;
 
     #if defined(FK_NATURALIST)
     const char *display_name = "FieldKit Naturalist";
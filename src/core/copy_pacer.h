@@ -0,0 +1,148 @@
+#ifndef FK_COPY_PACER_H_INCLUDED
+#define FK_COPY_PACER_H_INCLUDED
+
+#include <cinttypes>
+#include <cstdlib>
+
+#include "tuning.h"
+
+namespace fk {
+
+/**
+ * Counts of values in power of two buckets, bucket i holding values below
+ * 2^i and the last everything else.
+ */
+template<size_t N>
+class Log2Histogram {
+private:
+    uint32_t counts_[N];
+
+public:
+    Log2Histogram() {
+        clear();
+    }
+
+public:
+    void clear() {
+        for (size_t i = 0; i < N; ++i) {
+            counts_[i] = 0;
+        }
+    }
+
+    void add(uint32_t value) {
+        size_t bucket = 0;
+        while (bucket < N - 1 && value >= ((uint32_t)1 << bucket)) {
+            bucket++;
+        }
+        counts_[bucket]++;
+    }
+
+    uint32_t get(size_t bucket) const {
+        return counts_[bucket];
+    }
+
+    size_t size() const {
+        return N;
+    }
+
+};
+
+/**
+ * Decides how much a file copy reads at a time and how long it keeps at it
+ * before giving the rest of the loop a turn, from how quickly the writer
+ * takes what it's given. Chunks grow a sector at a time while writes are
+ * quick and halve when one stalls, slices double after one that went well
+ * and halve after a stall, so a slow or congested connection gets small
+ * pieces and hands back control often.
+ *
+ * Slice throughput in bytes per second and stall lengths in milliseconds
+ * are kept as histograms.
+ */
+class CopyPacer {
+private:
+    uint32_t chunk_{ FileCopyMinimumChunk };
+    uint32_t slice_{ FileCopyMinimumSlice };
+    bool stalled_{ false };
+    Log2Histogram<FileCopyHistogramBuckets> throughput_;
+    Log2Histogram<FileCopyHistogramBuckets> stalls_;
+
+public:
+    void begin() {
+        chunk_ = FileCopyMinimumChunk;
+        slice_ = FileCopyMinimumSlice;
+        stalled_ = false;
+        throughput_.clear();
+        stalls_.clear();
+    }
+
+    /**
+     * Bytes to read next.
+     */
+    uint32_t chunk() const {
+        return chunk_;
+    }
+
+    /**
+     * Milliseconds the current slice may run for.
+     */
+    uint32_t slice() const {
+        return slice_;
+    }
+
+    /**
+     * After each write, returns false if it stalled and the slice should
+     * end early.
+     */
+    bool wrote(uint32_t bytes, uint32_t elapsed) {
+        if (bytes == 0 || elapsed >= FileCopyStallThreshold) {
+            stalled();
+            stalls_.add(elapsed);
+            return false;
+        }
+
+        if (chunk_ + FileCopyMinimumChunk <= FileCopyTransferSize) {
+            chunk_ += FileCopyMinimumChunk;
+        }
+
+        return true;
+    }
+
+    /**
+     * The writer, or whoever it's writing for, asked for a break.
+     */
+    void stalled() {
+        stalled_ = true;
+        chunk_ = chunk_ / 2 >= FileCopyMinimumChunk ? chunk_ / 2 : FileCopyMinimumChunk;
+    }
+
+    /**
+     * At the end of each slice.
+     */
+    void sliced(uint32_t bytes, uint32_t elapsed) {
+        if (elapsed > 0) {
+            throughput_.add((uint32_t)((uint64_t)bytes * 1000 / elapsed));
+        }
+
+        if (stalled_) {
+            slice_ = slice_ / 2 >= FileCopyMinimumSlice ? slice_ / 2 : FileCopyMinimumSlice;
+        }
+        else {
+            slice_ = slice_ * 2 <= FileCopyMaximumElapsed ? slice_ * 2 : FileCopyMaximumElapsed;
+        }
+
+        stalled_ = false;
+    }
+
+    const Log2Histogram<FileCopyHistogramBuckets> &throughput() const {
+        return throughput_;
+    }
+
+    const Log2Histogram<FileCopyHistogramBuckets> &stalls() const {
+        return stalls_;
+    }
+
+};
+
+}
+
+#endif
@@ -89,14 +89,21 @@ void CoreState::merge(ModuleInfo &module, IncomingSensorReading &incoming) {
     reading.value = incoming.value;
     reading.status = SensorReadingStatus::Done;
 
-    if (isTimeOff(reading.time)) {
+    if (isTimeOff(reading.time) && !isBufferedTime(reading.time)) {
         auto now = clock.getTime();
         auto difference = abs(now - reading.time);
         log("Fixing reading with drifted time: %lu - %lu = %d", now, reading.time, difference);
         reading.time = now;
     }
 
-    data_->appendReading(*this, location_, readingNumber_, incoming.sensor, sensor, reading);
+    data_->appendReading(*this, location_, readingNumber_, sensorIndex(module, incoming.sensor), sensor, reading);
+}
+
+bool CoreState::isBufferedTime(uint32_t time) const {
+    // Modules sampling on their own hand us readings from well before now,
+    // those are fine so long as they aren't from the future or ancient.
+    auto now = clock.getTime();
+    return time > 0 && time <= now && now - time < BufferedReadingsMaximumAge;
 }
 
 bool CoreState::hasModuleWithAddress(uint8_t address) {
@@ -179,6 +186,14 @@ size_t CoreState::numberOfSensors() const {
     return number;
 }
 
+uint32_t CoreState::sensorIndex(const ModuleInfo &module, uint8_t sensor) const {
+    uint32_t index = 0;
+    for (auto m = attachedModules(); m != nullptr && m != &module; m = m->np) {
+        index += m->numberOfSensors;
+    }
+    return index + sensor;
+}
+
 size_t CoreState::numberOfReadings() const {
     size_t number = 0;
     for (auto m = attachedModules(); m != nullptr; m = m->np) {
@@ -192,13 +207,17 @@ size_t CoreState::numberOfReadings() const {
 }
 
 size_t CoreState::readingsToTake() const {
+    size_t number = 0;
     for (auto m = attachedModules(); m != nullptr; m = m->np) {
         if (m->type == fk_module_ModuleType_SENSOR) {
-            // NOTE: We only support one sensor module right now.
-            return m->minimumNumberOfReadings;
+            // Modules are gathered from together, so take enough for the
+            // neediest of them.
+            if (m->minimumNumberOfReadings > number) {
+                number = m->minimumNumberOfReadings;
+            }
         }
     }
-    return 1;
+    return number > 0 ? number : 1;
 }
 
 AvailableSensorReading CoreState::getReading(size_t index) {
@@ -281,6 +300,11 @@ void CoreState::copyTo(PersistedState &state) {
 
 void CoreState::takingReadings() {
     readingNumber_++;
+    data_->beginReadings();
+}
+
+void CoreState::readingsDone() {
+    data_->commitReadings(*this, location_);
 }
 
 ModuleInfo* CoreState::attachedModules() const {
@@ -307,6 +331,10 @@ BatteryStatus& CoreState::getBatteryStatus() {
     return deviceStatus_.battery;
 }
 
+ReadingLatencies<MaximumNumberOfSensors>& CoreState::getLatencies() {
+    return latencies_;
+}
+
 bool CoreState::hasModules() {
     return numberOfModules() > 0;
 }
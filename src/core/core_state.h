@@ -9,6 +9,7 @@
 #include "two_wire_task.h"
 #include "data_logging.h"
 #include "flash_storage.h"
+#include "reading_latency.h"
 
 namespace fk {
 
@@ -20,6 +21,7 @@ private:
     NetworkSettings networkSettings_;
     DeviceLocation location_;
     uint32_t readingNumber_{ 0 };
+    ReadingLatencies<MaximumNumberOfSensors> latencies_;
 
 private:
     DeviceStatus deviceStatus_;
@@ -38,6 +40,14 @@ public:
     }
 
     size_t numberOfSensors() const;
+
+    /**
+     * Index of the module's sensor among every attached sensor, in the order
+     * they appear in the data file's metadata. This is what readings are
+     * logged under so sensors on different modules don't collide.
+     */
+    uint32_t sensorIndex(const ModuleInfo &module, uint8_t sensor) const;
+
     size_t numberOfReadings() const;
     size_t readingsToTake() const;
     ModuleInfo *getModuleByIndex(uint8_t index);
@@ -51,6 +61,7 @@ public:
     DeviceStatus& getStatus();
     NetworkSettings& getNetworkSettings();
     BatteryStatus& getBatteryStatus();
+    ReadingLatencies<MaximumNumberOfSensors>& getLatencies();
 
 public:
     void started();
@@ -58,6 +69,7 @@ public:
 public:
     AvailableSensorReading getReading(size_t index);
     void takingReadings();
+    void readingsDone();
     void clearReadings();
 
     void doneScanning();
@@ -78,6 +90,7 @@ public:
 private:
     ModuleInfo *getOrCreateModule(uint8_t address, uint8_t numberOfSensors);
     bool appendReading(SensorReading &reading);
+    bool isBufferedTime(uint32_t time) const;
     void copyFrom(PersistedState &state);
     void copyTo(PersistedState &state);
     void save();
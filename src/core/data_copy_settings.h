@@ -14,6 +14,28 @@ enum class FileNumber : uint8_t {
     None = 0xff
 };
 
+/**
+ * Our own flag, above those defined by the app protocol's DownloadFlags. When
+ * set offset and length are the beginning and end of a range of times rather
+ * than bytes, an end of zero meaning now.
+ */
+constexpr uint32_t FileCopyFlagTimeRange = 0x100;
+
+/**
+ * Rather than the data file itself reply with a summary of the readings in
+ * the time range, see data_summary.h. The width of each bucket, in minutes,
+ * is in the top 16 bits of the flags.
+ */
+constexpr uint32_t FileCopyFlagSummary = 0x200;
+constexpr uint32_t FileCopySummaryWidthShift = 16;
+
+/**
+ * Everything after the reply header is compressed, see lzss.h. The size in
+ * the header is still the uncompressed size, which is how much the app should
+ * expect once it's decompressed.
+ */
+constexpr uint32_t FileCopyFlagCompressed = 0x400;
+
 struct FileCopySettings {
     FileNumber file{ FileNumber::None };
     uint32_t offset{ 0 };
@@ -28,6 +50,22 @@ struct FileCopySettings {
 
     FileCopySettings(FileNumber file, uint32_t offset, uint32_t length, uint32_t flags = 0) : file(file), offset(offset), length(length), flags(flags) {
     }
+
+    bool isTimeRange() const {
+        return flags & (FileCopyFlagTimeRange | FileCopyFlagSummary);
+    }
+
+    bool isSummary() const {
+        return file == FileNumber::Data && (flags & FileCopyFlagSummary);
+    }
+
+    bool isCompressed() const {
+        return flags & FileCopyFlagCompressed;
+    }
+
+    uint32_t summaryWidth() const {
+        return (flags >> FileCopySummaryWidthShift) * 60;
+    }
 };
 
 }
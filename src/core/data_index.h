@@ -0,0 +1,205 @@
+#ifndef FK_DATA_INDEX_H_INCLUDED
+#define FK_DATA_INDEX_H_INCLUDED
+
+#include <cinttypes>
+#include <cstdlib>
+
+namespace fk {
+
+struct DataIndexEntry {
+    uint32_t time;
+    uint32_t reading;
+    uint32_t position;
+};
+
+/**
+ * Sparse index of the data file, mapping the time and reading number of
+ * records to where they begin in the file. An entry is kept every stride
+ * bytes and when the index fills up every other entry is dropped and the
+ * stride doubled, so N entries always cover the whole file at a coarser
+ * resolution as it grows.
+ *
+ * Times are reading times, which modules that buffer readings hand over
+ * late and out of order, so an entry's time is the latest of any record
+ * before it rather than the time of the record it points at. Every record
+ * before an entry is then no later than the entry, which is what makes
+ * begin conservative however readings arrive.
+ */
+template<size_t N>
+class DataIndex {
+private:
+    DataIndexEntry entries_[N];
+    size_t size_{ 0 };
+    uint32_t initialStride_;
+    uint32_t stride_;
+    uint32_t latest_{ 0 };
+    size_t saved_{ 0 };
+    bool rewrite_{ true };
+
+public:
+    DataIndex(uint32_t stride) : initialStride_(stride), stride_(stride) {
+    }
+
+public:
+    void clear() {
+        clear(initialStride_);
+    }
+
+    void clear(uint32_t stride) {
+        size_ = 0;
+        stride_ = stride;
+        latest_ = 0;
+        saved_ = 0;
+        rewrite_ = true;
+    }
+
+    /**
+     * Called before each record is written with the latest reading time,
+     * reading number and position of that record. Returns true if an entry
+     * was added.
+     */
+    bool append(uint32_t time, uint32_t reading, uint32_t position) {
+        auto latest = latest_;
+        if (time > latest_) {
+            latest_ = time;
+        }
+
+        if (size_ > 0) {
+            auto &last = entries_[size_ - 1];
+            // The file was erased out from under us.
+            if (position < last.position) {
+                size_ = 0;
+                saved_ = 0;
+                rewrite_ = true;
+            }
+            else if (position - last.position < stride_) {
+                return false;
+            }
+        }
+
+        if (size_ == N) {
+            for (size_t i = 1; i < N / 2; ++i) {
+                entries_[i] = entries_[i * 2];
+            }
+            size_ = N / 2;
+            stride_ *= 2;
+            saved_ = 0;
+            rewrite_ = true;
+        }
+
+        entries_[size_++] = DataIndexEntry{ latest, reading, position };
+
+        return true;
+    }
+
+    /**
+     * Adds an entry read back from storage as is, after clear(stride).
+     */
+    bool restore(const DataIndexEntry &entry) {
+        if (size_ == N || (size_ > 0 && entry.position < entries_[size_ - 1].position)) {
+            return false;
+        }
+        if (entry.time > latest_) {
+            latest_ = entry.time;
+        }
+        entries_[size_++] = entry;
+        return true;
+    }
+
+    /**
+     * Records written before now may be as late as time, after a restart
+     * the records after the last entry haven't been seen.
+     */
+    void advance(uint32_t time) {
+        if (time > latest_) {
+            latest_ = time;
+        }
+    }
+
+    /**
+     * Position to begin reading from to get every record at or after time,
+     * zero if that's before the first entry.
+     */
+    uint32_t begin(uint32_t time) const {
+        uint32_t position = 0;
+        for (size_t i = 0; i < size_; ++i) {
+            if (entries_[i].time >= time) {
+                break;
+            }
+            position = entries_[i].position;
+        }
+        return position;
+    }
+
+    /**
+     * Position of the first entry later than time, zero if there isn't one
+     * and the copy should run to the end. Records after an entry can be
+     * earlier than it when they were buffered, callers allow for how much.
+     */
+    uint32_t end(uint32_t time) const {
+        for (size_t i = 0; i < size_; ++i) {
+            if (entries_[i].time > time) {
+                return entries_[i].position;
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * Position to begin reading from to get every record with a reading
+     * number at or after reading.
+     */
+    uint32_t beginReading(uint32_t reading) const {
+        uint32_t position = 0;
+        for (size_t i = 0; i < size_; ++i) {
+            if (entries_[i].reading >= reading) {
+                break;
+            }
+            position = entries_[i].position;
+        }
+        return position;
+    }
+
+    /**
+     * True if entries have changed since markSaved. When rewrite() is true
+     * the whole index has to be saved again, otherwise only the entries
+     * after saved().
+     */
+    bool dirty() const {
+        return rewrite_ || saved_ < size_;
+    }
+
+    bool rewrite() const {
+        return rewrite_;
+    }
+
+    size_t saved() const {
+        return saved_;
+    }
+
+    void markSaved() {
+        saved_ = size_;
+        rewrite_ = false;
+    }
+
+    void markUnsaved() {
+        rewrite_ = true;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    uint32_t stride() const {
+        return stride_;
+    }
+
+    const DataIndexEntry &get(size_t i) const {
+        return entries_[i];
+    }
+
+};
+
+}
+
+#endif
@@ -9,6 +9,9 @@
 #include "debug.h"
 #include "device_id.h"
 #include "protobuf.h"
+#include "configuration.h"
+#include "reading_block.h"
+#include "record_frame.h"
 
 namespace fk {
 
@@ -23,7 +26,7 @@ bool DataLogging::appendMetadata(CoreState &state) {
     EmptyPool pool;
     DataRecordMetadataMessage message{ state, pool };
 
-    auto size = append(message);
+    auto size = append(message, clock.getTime());
 
     Logger::info("Appended metadata (%d bytes)", size);
 
@@ -38,7 +41,7 @@ bool DataLogging::appendStatus(CoreState &state) {
     EmptyPool pool;
     DataRecordStatusMessage message{ state, pool };
 
-    auto size = append(message);
+    auto size = append(message, clock.getTime());
 
     Logger::info("Appended status (%d bytes)", size);
 
@@ -68,7 +71,7 @@ bool DataLogging::appendLocation(CoreState &state, DeviceLocation &location) {
     message.m().status.memory = 0;
     message.m().status.busy = 0;
 
-    auto size = append(message);
+    auto size = append(message, time);
 
     Logger::info("Appended location (%d bytes)", size);
 
@@ -76,6 +79,23 @@ bool DataLogging::appendLocation(CoreState &state, DeviceLocation &location) {
 }
 
 bool DataLogging::appendReading(CoreState &state, DeviceLocation &location, uint32_t readingNumber, uint32_t sensorId, SensorInfo &sensor, SensorReading &reading) {
+    readingNumber_ = readingNumber;
+
+    if (batching_) {
+        if (numberOfBatched_ == MaximumNumberOfSensors) {
+            if (!commitReadings(state, location)) {
+                return false;
+            }
+            batching_ = true;
+        }
+
+        batched_[numberOfBatched_++] = BatchedReading{ readingNumber, sensorId, reading };
+
+        Logger::trace("Batched reading (%lu, %lu, '%s' = %f)", reading.time, sensorId, sensor.name, reading.value);
+
+        return true;
+    }
+
     if (!appendMetadataIfNecessary(state)) {
         return false;
     }
@@ -102,22 +122,265 @@ bool DataLogging::appendReading(CoreState &state, DeviceLocation &location, uint
     message.m().status.memory = 0;
     message.m().status.busy = 0;
 
-    auto size = append(message);
+    auto size = append(message, reading.time);
 
     Logger::info("Appended reading (%d bytes) (%lu, %lu, '%s' = %f)", size, reading.time, sensorId, sensor.name, reading.value);
 
     return true;
 }
 
+void DataLogging::beginReadings() {
+    batching_ = true;
+    numberOfBatched_ = 0;
+}
+
+bool DataLogging::commitReadings(CoreState &state, DeviceLocation &location) {
+    if (!batching_) {
+        return true;
+    }
+
+    batching_ = false;
+
+    if (numberOfBatched_ == 0) {
+        return true;
+    }
+
+    auto staged = (size_t)0;
+    auto success = appendMetadataIfNecessary(state);
+    if (success) {
+        if (configuration.data.reading_blocks) {
+            success = commitReadingBlocks(location, staged);
+        }
+        else {
+            success = commitReadingRecords(location, staged);
+        }
+    }
+
+    if (!success) {
+        Logger::error("Lost %d of %d batched readings", numberOfBatched_ - staged, numberOfBatched_);
+    }
+
+    numberOfBatched_ = 0;
+
+    return success;
+}
+
+bool DataLogging::commitReadingRecords(DeviceLocation &location, size_t &staged) {
+    auto &file = files->stagedData();
+    auto total = (size_t)0;
+    auto appends = 0;
+    auto time = clock.getTime();
+    auto latest = latestBatched();
+
+    // Records are encoded straight into the staged file, as many to a frame
+    // as there's room for.
+    uint8_t *ptr = nullptr;
+    auto available = (size_t)0;
+    auto stream = pb_ostream_t{};
+    auto encoded = (size_t)0;
+
+    for (size_t i = 0; i < numberOfBatched_; ++i) {
+        auto &batched = batched_[i];
+
+        EmptyPool pool;
+        DataRecordMessage message{ pool };
+
+        // Every record carries the location and status, readers take a
+        // record without a location as one taken without a fix.
+        message.m().loggedReading.version = 1;
+        message.m().loggedReading.location.fix = location.valid;
+        message.m().loggedReading.location.time = location.time;
+        message.m().loggedReading.location.longitude = location.coordinates[0];
+        message.m().loggedReading.location.latitude = location.coordinates[1];
+        message.m().loggedReading.location.altitude = location.coordinates[2];
+        message.m().loggedReading.reading.reading = batched.readingNumber;
+        message.m().loggedReading.reading.time = batched.reading.time;
+        message.m().loggedReading.reading.sensor = batched.sensorId;
+        message.m().loggedReading.reading.value = batched.reading.value;
+
+        message.m().status.time = time;
+        message.m().status.uptime = fk_uptime();
+        message.m().status.battery = 0.0f;
+        message.m().status.memory = 0;
+        message.m().status.busy = 0;
+
+        auto size = message.calculateSize();
+        if (size == 0) {
+            Logger::error("Error sizing batched reading");
+            return false;
+        }
+
+        if (ptr != nullptr && stream.bytes_written + size > available) {
+            if (!appendReserved(stream.bytes_written, latest)) {
+                return false;
+            }
+            total += stream.bytes_written;
+            appends++;
+            staged += encoded;
+            encoded = 0;
+            ptr = nullptr;
+        }
+
+        if (ptr == nullptr) {
+            ptr = file.reserve(size, available);
+            if (ptr == nullptr) {
+                Logger::error("Error reserving batched reading (%d bytes)", size);
+                return false;
+            }
+            stream = pb_ostream_from_buffer(ptr, available);
+        }
+
+        if (!pb_encode_delimited(&stream, fk_data_DataRecord_fields, message.forEncode())) {
+            Logger::error("Error encoding batched reading (%d bytes)", size);
+            return false;
+        }
+
+        encoded++;
+    }
+
+    if (!appendReserved(stream.bytes_written, latest)) {
+        return false;
+    }
+    total += stream.bytes_written;
+    appends++;
+    staged += encoded;
+
+    Logger::info("Appended %d readings (%d bytes) (%d appends)", numberOfBatched_, total, appends);
+
+    return true;
+}
+
+bool DataLogging::commitReadingBlocks(DeviceLocation &location, size_t &staged) {
+    auto &file = files->stagedData();
+    auto total = (size_t)0;
+    auto appends = 0;
+    auto blocks = 0;
+    auto latest = latestBatched();
+
+    // Location and status are shared by every block in the batch.
+    EmptyPool pool;
+    DataRecordMessage message{ pool };
+
+    message.m().loggedReading.version = 1;
+    message.m().loggedReading.location.fix = location.valid;
+    message.m().loggedReading.location.time = location.time;
+    message.m().loggedReading.location.longitude = location.coordinates[0];
+    message.m().loggedReading.location.latitude = location.coordinates[1];
+    message.m().loggedReading.location.altitude = location.coordinates[2];
+
+    message.m().status.time = clock.getTime();
+    message.m().status.uptime = fk_uptime();
+    message.m().status.battery = 0.0f;
+    message.m().status.memory = 0;
+    message.m().status.busy = 0;
+
+    // Blocks are encoded straight into the staged file after the location,
+    // as many to a frame as there's room for.
+    auto available = (size_t)0;
+    auto buffer = file.reserve(message.calculateSize(), available);
+    if (buffer == nullptr) {
+        Logger::error("Error reserving batch location");
+        return false;
+    }
+
+    auto stream = pb_ostream_from_buffer(buffer, available);
+    if (!pb_encode_delimited(&stream, fk_data_DataRecord_fields, message.forEncode())) {
+        Logger::error("Error encoding batch location");
+        return false;
+    }
+
+    auto position = stream.bytes_written;
+    auto encoded = (size_t)0;
+
+    ReadingBlockEncoder encoder{ configuration.data.precision };
+    BlockReading readings[MaximumNumberOfSensors];
+    auto number = (size_t)0;
+    auto readingNumber = batched_[0].readingNumber;
+
+    // Blocks hold one reading per sensor, so a sensor we've already got or a
+    // new reading number starts another block.
+    for (size_t i = 0; i <= numberOfBatched_; ++i) {
+        auto flush = i == numberOfBatched_;
+        if (!flush) {
+            auto &batched = batched_[i];
+            flush = batched.readingNumber != readingNumber;
+            for (size_t j = 0; j < number && !flush; ++j) {
+                flush = readings[j].sensor == batched.sensorId;
+            }
+        }
+
+        if (flush && number > 0) {
+            auto size = encoder.encode(buffer + position, available - position, readingNumber, readings, number);
+            if (size == 0 && position > 0) {
+                if (!appendReserved(position, latest)) {
+                    return false;
+                }
+                total += position;
+                appends++;
+                staged += encoded;
+                encoded = 0;
+                position = 0;
+                buffer = file.reserve(StagedFileBufferSize - RecordFrameHeaderSize, available);
+                if (buffer == nullptr) {
+                    Logger::error("Error reserving reading block");
+                    return false;
+                }
+                size = encoder.encode(buffer, available, readingNumber, readings, number);
+            }
+            if (size == 0) {
+                Logger::error("Error encoding reading block (%d readings)", number);
+                return false;
+            }
+            position += size;
+            encoded += number;
+            number = 0;
+            blocks++;
+        }
+
+        if (i < numberOfBatched_) {
+            auto &batched = batched_[i];
+            readingNumber = batched.readingNumber;
+            readings[number++] = BlockReading{ (uint8_t)batched.sensorId, batched.reading.time, batched.reading.value };
+        }
+    }
+
+    if (position > 0) {
+        if (!appendReserved(position, latest)) {
+            return false;
+        }
+        total += position;
+        appends++;
+        staged += encoded;
+    }
+
+    Logger::info("Appended %d readings in %d blocks (%d bytes) (%d appends)", numberOfBatched_, blocks, total, appends);
+
+    return true;
+}
+
+uint32_t DataLogging::latestBatched() const {
+    auto latest = (uint32_t)0;
+    for (size_t i = 0; i < numberOfBatched_; ++i) {
+        if (batched_[i].reading.time > latest) {
+            latest = batched_[i].reading.time;
+        }
+    }
+    return latest;
+}
+
+void DataLogging::erased() {
+    index_.clear();
+}
+
 bool DataLogging::appendMetadataIfNecessary(CoreState &state) {
-    if (files->data().tell() > 0) {
+    if (files->stagedData().tell() > 0) {
         return true;
     }
 
     return appendMetadata(state);
 }
 
-size_t DataLogging::append(DataRecordMessage &message) {
+size_t DataLogging::append(DataRecordMessage &message, uint32_t time) {
     size_t size;
 
     if (!pb_get_encoded_size(&size, fk_data_DataRecord_fields, message.forEncode())) {
@@ -131,14 +394,44 @@ size_t DataLogging::append(DataRecordMessage &message) {
         return 0;
     }
 
-    auto bytes = stream.bytes_written;
-    auto written = (uint32_t)files->data().write(buffer, bytes, true);
-    if (written != bytes) {
-        Logger::error("Error appending data file (%d != %lu).", bytes, written);
+    if (!write(buffer, stream.bytes_written, time)) {
         return 0;
     }
 
     return stream.bytes_written;
 }
 
+bool DataLogging::write(uint8_t *buffer, size_t bytes, uint32_t time) {
+    indexAppend(time);
+
+    if (!files->stagedData().append(buffer, bytes)) {
+        Logger::error("Error appending data file (%d bytes).", bytes);
+        return false;
+    }
+
+    return true;
+}
+
+bool DataLogging::appendReserved(size_t bytes, uint32_t time) {
+    indexAppend(time);
+
+    if (!files->stagedData().appendReserved(bytes)) {
+        Logger::error("Error appending data file (%d bytes).", bytes);
+        return false;
+    }
+
+    return true;
+}
+
+void DataLogging::indexAppend(uint32_t time) {
+    // Indexed by the latest reading time in the records, those from before
+    // the clock was set would only confuse lookups.
+    if (time > firmware_compiled_get()) {
+        auto position = files->stagedData().tell();
+        if (index_.append(time, readingNumber_, position)) {
+            Logger::trace("Indexed %lu (#%lu) at %lu (%d entries)", time, readingNumber_, position, index_.size());
+        }
+    }
+}
+
 }
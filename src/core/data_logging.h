@@ -5,14 +5,26 @@
 #include "data_messages.h"
 #include "flash_state.h"
 #include "files.h"
+#include "data_index.h"
 
 namespace fk {
 
 class CoreState;
 
+struct BatchedReading {
+    uint32_t readingNumber;
+    uint32_t sensorId;
+    SensorReading reading;
+};
+
 class DataLogging {
 private:
     Files *files;
+    bool batching_{ false };
+    size_t numberOfBatched_{ 0 };
+    BatchedReading batched_[MaximumNumberOfSensors];
+    uint32_t readingNumber_{ 0 };
+    DataIndex<DataIndexSize> index_{ DataIndexStride };
 
 public:
     DataLogging(Files &files);
@@ -23,9 +35,35 @@ public:
     bool appendLocation(CoreState &state, DeviceLocation &location);
     bool appendReading(CoreState &state, DeviceLocation &location, uint32_t readingNumber, uint32_t sensorId, SensorInfo &sensor, SensorReading &reading);
 
+    /**
+     * Readings appended after this are kept in RAM until commitReadings,
+     * which writes them all to the data file at once.
+     */
+    void beginReadings();
+    bool commitReadings(CoreState &state, DeviceLocation &location);
+
+    /**
+     * Forget the index, after the data file is erased.
+     */
+    void erased();
+
+    DataIndex<DataIndexSize> &index() {
+        return index_;
+    }
+
+    const DataIndex<DataIndexSize> &index() const {
+        return index_;
+    }
+
 private:
     bool appendMetadataIfNecessary(CoreState &state);
-    size_t append(DataRecordMessage &message);
+    bool commitReadingRecords(DeviceLocation &location, size_t &staged);
+    bool commitReadingBlocks(DeviceLocation &location, size_t &staged);
+    size_t append(DataRecordMessage &message, uint32_t time);
+    uint32_t latestBatched() const;
+    bool write(uint8_t *buffer, size_t bytes, uint32_t time);
+    bool appendReserved(size_t bytes, uint32_t time);
+    void indexAppend(uint32_t time);
 
 };
 
@@ -21,7 +21,8 @@ DataRecordMetadataMessage::DataRecordMetadataMessage(CoreState &state, Pool &poo
     auto numberOfModules = 0;
     for (auto m = state.attachedModules(); m != nullptr; m = m->np) {
         for (size_t i = 0; i < m->numberOfSensors; ++i) {
-            sensors[sensorIndex].number = i;
+            // Readings are logged under this, see CoreState::sensorIndex.
+            sensors[sensorIndex].number = sensorIndex;
             sensors[sensorIndex].name.funcs.encode = pb_encode_string;
             sensors[sensorIndex].name.arg = (void *)m->sensors[i].name;
             sensors[sensorIndex].unitOfMeasure.funcs.encode = pb_encode_string;
@@ -1,11 +1,11 @@
 #include <new>
+#include <alogging/sprintf.h>
 
 #include "tuning.h"
 #include "debug.h"
 #include "data_replies.h"
 #include "file_system.h"
 #include "core_state.h"
-#include "file_cursors.h"
 
 namespace fk {
 
@@ -26,12 +26,12 @@ void DataReplies::queryFilesReply(AppQueryMessage &query, AppReplyMessage &reply
         auto &fd = files.file(i);
 
         if (!fileSystem->files().isInternal(fd)) {
-            auto stat = fileSystem->fs().stat(fd);
+            auto stat = fileSystem->stat((FileNumber)i);
             auto j = numberOfVisibleFiles;
             replyFiles[j].id = i;
             replyFiles[j].time = 0;
             replyFiles[j].version = stat.version;
-            replyFiles[j].size = stat.size;
+            replyFiles[j].size = fileSystem->base((FileNumber)i) + stat.size;
             replyFiles[j].maximum = fd.maximum_size;
             replyFiles[j].name.funcs.encode = pb_encode_string;
             replyFiles[j].name.arg = fd.name;
@@ -50,6 +50,15 @@ void DataReplies::queryFilesReply(AppQueryMessage &query, AppReplyMessage &reply
     reply.m().files.files.funcs.encode = pb_encode_array;
     reply.m().files.files.arg = (void *)&filesArray;
 
+    // Files being erased report a size of zero, the app's told how many are
+    // left so it knows to ask again rather than thinking they're empty.
+    auto erasing = fileSystem->erasing();
+    if (erasing > 0) {
+        char status[32];
+        alogging_snprintf(status, sizeof(status), "Erasing %d files", erasing);
+        reply.status(status);
+    }
+
     if (!buffer.write(reply)) {
         Logger::error("Error writing reply");
     }
@@ -62,11 +71,6 @@ void DataReplies::eraseFileReply(AppQueryMessage &query, AppReplyMessage &reply,
         Logger::error("Failed to erase file: %d", number);
     }
 
-    FileCursorManager fcm(*fileSystem);
-    if (!fcm.save(number, 0)) {
-        Logger::error("Failed to save cursor: %d", sizeof(FileCursors));
-    }
-
     queryFilesReply(query, reply, buffer);
 }
 
@@ -85,7 +89,18 @@ void DataReplies::eraseAll(CoreState &state) {
         return;
     }
 
-    state.started();
+    restarting = &state;
+
+    Logger::info("Reset queued.");
+}
+
+void DataReplies::erased() {
+    if (restarting == nullptr) {
+        return;
+    }
+
+    restarting->started();
+    restarting = nullptr;
 
     Logger::info("Reset done.");
 }
@@ -12,6 +12,7 @@ class FileSystem;
 class DataReplies {
 private:
     FileSystem *fileSystem;
+    CoreState *restarting{ nullptr };
 
 public:
     DataReplies(FileSystem &fileSystem);
@@ -19,8 +20,17 @@ public:
 public:
     void queryFilesReply(AppQueryMessage &query, AppReplyMessage &reply, MessageBuffer &buffer);
     void eraseFileReply(AppQueryMessage &query, AppReplyMessage &reply, MessageBuffer &buffer);
+    /**
+     * Erases every file, the state's started over once they're gone so
+     * nothing's appended to the files being erased.
+     */
     void eraseAll(CoreState &state);
 
+    /**
+     * Called once all pending erases are done.
+     */
+    void erased();
+
 };
 
 }
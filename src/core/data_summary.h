@@ -0,0 +1,274 @@
+#ifndef FK_DATA_SUMMARY_H_INCLUDED
+#define FK_DATA_SUMMARY_H_INCLUDED
+
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
+#include "tuning.h"
+
+namespace fk {
+
+/**
+ * Summaries are a header followed by a row per bucket, each row having a cell
+ * per sensor. Everything is little endian and fixed size so the length of a
+ * summary is known before the data file is scanned.
+ *
+ *   version    u8, DataSummaryVersion
+ *   sensors    u8
+ *   buckets    u16
+ *   start      u32, time the first bucket begins
+ *   width      u32, seconds per bucket
+ *
+ * Cells:
+ *
+ *   count      u32, zero for sensors without readings in the bucket
+ *   minimum    f32
+ *   mean       f32
+ *   maximum    f32
+ */
+constexpr uint8_t DataSummaryVersion = 1;
+constexpr size_t DataSummaryHeaderSize = 12;
+constexpr size_t DataSummaryCellSize = 16;
+
+struct SummaryCell {
+    uint32_t count;
+    float minimum;
+    float maximum;
+    float sum;
+};
+
+/**
+ * Reduces readings to per bucket statistics for each sensor as they're
+ * scanned from the data file, keeping only the bucket being filled. Readings
+ * are expected in time order, readings for buckets that have already been
+ * closed are counted as late and dropped.
+ *
+ * When a reading belongs to a later bucket the current one is closed and add
+ * returns false until read has taken the closed row, the reading should then
+ * be added again.
+ */
+template<size_t N>
+class DataSummary {
+private:
+    uint32_t start_{ 0 };
+    uint32_t width_{ 0 };
+    uint16_t buckets_{ 0 };
+    uint8_t sensors_{ 0 };
+    uint16_t current_{ 0 };
+    bool closing_{ false };
+    bool finished_{ false };
+    bool header_{ false };
+    uint16_t emitRow_{ 0 };
+    uint8_t emitSensor_{ 0 };
+    uint8_t pending_[DataSummaryCellSize];
+    size_t pendingSize_{ 0 };
+    size_t pendingPosition_{ 0 };
+    uint32_t late_{ 0 };
+    uint32_t outside_{ 0 };
+    SummaryCell cells_[N];
+
+public:
+    /**
+     * Begins a summary of the readings from start until end, in buckets of
+     * width seconds. Ranges needing more than DataSummaryMaximumBuckets keep
+     * the most recent buckets.
+     */
+    void begin(uint32_t start, uint32_t end, uint32_t width, uint8_t sensors) {
+        if (width == 0) {
+            width = DataSummaryDefaultWidth;
+        }
+        if (sensors > N) {
+            sensors = N;
+        }
+
+        auto buckets = end > start && sensors > 0 ? (end - start + width - 1) / width : 0;
+        if (buckets > DataSummaryMaximumBuckets) {
+            buckets = DataSummaryMaximumBuckets;
+            start = end - buckets * width;
+        }
+
+        start_ = start;
+        width_ = width;
+        buckets_ = (uint16_t)buckets;
+        sensors_ = sensors;
+        current_ = 0;
+        closing_ = false;
+        finished_ = false;
+        header_ = false;
+        emitRow_ = 0;
+        emitSensor_ = 0;
+        pendingSize_ = 0;
+        pendingPosition_ = 0;
+        late_ = 0;
+        outside_ = 0;
+        clearCells();
+    }
+
+    /**
+     * Number of bytes the whole summary will be.
+     */
+    size_t size() const {
+        return DataSummaryHeaderSize + (size_t)buckets_ * sensors_ * DataSummaryCellSize;
+    }
+
+    bool add(uint8_t sensor, uint32_t time, float value) {
+        if (finished_ || sensor >= sensors_ || time < start_) {
+            outside_++;
+            return true;
+        }
+
+        auto bucket = (time - start_) / width_;
+        if (bucket >= buckets_) {
+            outside_++;
+            return true;
+        }
+
+        if (bucket < current_) {
+            late_++;
+            return true;
+        }
+
+        if (bucket > current_) {
+            closing_ = true;
+            if (emitRow_ <= current_) {
+                return false;
+            }
+            current_ = (uint16_t)bucket;
+            closing_ = false;
+            clearCells();
+        }
+
+        auto &cell = cells_[sensor];
+        if (cell.count == 0 || value < cell.minimum) {
+            cell.minimum = value;
+        }
+        if (cell.count == 0 || value > cell.maximum) {
+            cell.maximum = value;
+        }
+        cell.sum += value;
+        cell.count++;
+
+        return true;
+    }
+
+    /**
+     * No more readings are coming, every remaining bucket can be read.
+     */
+    void finish() {
+        finished_ = true;
+    }
+
+    /**
+     * Copies as much of the summary as is ready and fits into buffer.
+     */
+    size_t read(uint8_t *buffer, size_t size) {
+        size_t copied = 0;
+
+        while (copied < size) {
+            if (pendingPosition_ == pendingSize_ && !prepare()) {
+                break;
+            }
+
+            auto available = pendingSize_ - pendingPosition_;
+            auto n = available < size - copied ? available : size - copied;
+            memcpy(buffer + copied, pending_ + pendingPosition_, n);
+            pendingPosition_ += n;
+            copied += n;
+        }
+
+        return copied;
+    }
+
+    bool done() const {
+        return finished_ && header_ && emitRow_ >= buckets_ && pendingPosition_ == pendingSize_;
+    }
+
+    uint16_t buckets() const {
+        return buckets_;
+    }
+
+    uint32_t start() const {
+        return start_;
+    }
+
+    uint32_t late() const {
+        return late_;
+    }
+
+    uint32_t outside() const {
+        return outside_;
+    }
+
+private:
+    void clearCells() {
+        for (size_t i = 0; i < N; ++i) {
+            cells_[i] = SummaryCell{ 0, 0.0f, 0.0f, 0.0f };
+        }
+    }
+
+    bool prepare() {
+        pendingSize_ = 0;
+        pendingPosition_ = 0;
+
+        if (!header_) {
+            pending_[0] = DataSummaryVersion;
+            pending_[1] = sensors_;
+            put16(2, buckets_);
+            put32(4, start_);
+            put32(8, width_);
+            pendingSize_ = DataSummaryHeaderSize;
+            header_ = true;
+            return true;
+        }
+
+        if (emitRow_ >= buckets_) {
+            return false;
+        }
+
+        auto ready = finished_ || emitRow_ < current_ || (emitRow_ == current_ && closing_);
+        if (!ready) {
+            return false;
+        }
+
+        auto empty = SummaryCell{ 0, 0.0f, 0.0f, 0.0f };
+        auto &cell = emitRow_ == current_ ? cells_[emitSensor_] : empty;
+        auto mean = cell.count > 0 ? cell.sum / cell.count : 0.0f;
+
+        put32(0, cell.count);
+        putFloat(4, cell.minimum);
+        putFloat(8, mean);
+        putFloat(12, cell.maximum);
+        pendingSize_ = DataSummaryCellSize;
+
+        emitSensor_++;
+        if (emitSensor_ == sensors_) {
+            emitSensor_ = 0;
+            emitRow_++;
+        }
+
+        return true;
+    }
+
+    void put16(size_t offset, uint16_t value) {
+        pending_[offset + 0] = (uint8_t)(value);
+        pending_[offset + 1] = (uint8_t)(value >> 8);
+    }
+
+    void put32(size_t offset, uint32_t value) {
+        for (auto i = 0; i < 4; ++i) {
+            pending_[offset + i] = (uint8_t)(value >> (i * 8));
+        }
+    }
+
+    void putFloat(size_t offset, float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        put32(offset, bits);
+    }
+
+};
+
+}
+
+#endif
@@ -0,0 +1,158 @@
+#include "data_summary_writer.h"
+#include "data_messages.h"
+#include "debug.h"
+
+namespace fk {
+
+constexpr const char Log[] = "DataSummary";
+
+using Logger = SimpleLog<Log>;
+
+void DataSummaryWriter::begin(uint32_t start, uint32_t end, uint32_t width, uint8_t sensors) {
+    summary_.begin(start, end, width, sensors);
+    length_ = 0;
+    lengthShift_ = 0;
+    body_ = false;
+    position_ = 0;
+    records_ = 0;
+    readings_ = 0;
+    skipped_ = 0;
+    failed_ = false;
+
+    Logger::info("Summary from %lu in %d buckets of %lus (%d sensors, %d bytes)",
+                 summary_.start(), summary_.buckets(), width, sensors, summary_.size());
+}
+
+void DataSummaryWriter::target(lws::Writer &writer) {
+    target_ = &writer;
+}
+
+bool DataSummaryWriter::finish() {
+    summary_.finish();
+
+    if (!drain()) {
+        return false;
+    }
+
+    if (summary_.done()) {
+        Logger::info("Summarized %lu readings from %lu records (%lu skipped, %lu late, %lu outside)",
+                     readings_, records_, skipped_, summary_.late(), summary_.outside());
+        return true;
+    }
+
+    return false;
+}
+
+int32_t DataSummaryWriter::write(uint8_t *ptr, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        if (write(ptr[i]) != 1) {
+            return i > 0 ? (int32_t)i : EOS;
+        }
+    }
+    return size;
+}
+
+int32_t DataSummaryWriter::write(uint8_t byte) {
+    if (failed_) {
+        return EOS;
+    }
+
+    if (!body_) {
+        length_ |= (uint32_t)(byte & 0x7f) << lengthShift_;
+        lengthShift_ += 7;
+        if (byte & 0x80) {
+            if (lengthShift_ > 28) {
+                Logger::error("Malformed record length");
+                failed_ = true;
+                return EOS;
+            }
+            return 1;
+        }
+        body_ = true;
+        position_ = 0;
+    }
+    else {
+        if (position_ < sizeof(record_)) {
+            record_[position_] = byte;
+        }
+        position_++;
+    }
+
+    if (position_ == length_) {
+        if (length_ <= sizeof(record_)) {
+            record(record_, length_);
+        }
+        else {
+            skipped_++;
+        }
+        records_++;
+        length_ = 0;
+        lengthShift_ = 0;
+        body_ = false;
+    }
+
+    return failed_ ? EOS : 1;
+}
+
+void DataSummaryWriter::close() {
+}
+
+void DataSummaryWriter::record(uint8_t *ptr, size_t size) {
+    BlockReader reader{ ptr, size };
+
+    // Blocks are written as records with a single field.
+    if (reader.varint() == ((ReadingBlockField << 3) | 2)) {
+        auto length = (size_t)reader.varint();
+        if (!reader.failed() && length <= reader.remaining()) {
+            if (!reading_block_decode(reader.ptr(), length, *this)) {
+                skipped_++;
+            }
+            return;
+        }
+    }
+
+    // Nothing we're after is in a callback field, so those are skipped and
+    // decoding never allocates.
+    EmptyPool pool;
+    DataRecordMessage message{ pool };
+    auto stream = pb_istream_from_buffer(ptr, size);
+    if (!pb_decode(&stream, fk_data_DataRecord_fields, message.forDecode())) {
+        skipped_++;
+        return;
+    }
+
+    auto &reading = message.m().loggedReading.reading;
+    if (reading.time > 0) {
+        this->reading(reading.reading, (uint8_t)reading.sensor, reading.time, reading.value);
+    }
+}
+
+void DataSummaryWriter::reading(uint32_t number, uint8_t sensor, uint32_t time, float value) {
+    readings_++;
+
+    while (!summary_.add(sensor, time, value)) {
+        if (!drain()) {
+            return;
+        }
+    }
+}
+
+bool DataSummaryWriter::drain() {
+    uint8_t buffer[DataSummaryCellSize * 4];
+
+    while (!failed_) {
+        auto bytes = summary_.read(buffer, sizeof(buffer));
+        if (bytes == 0) {
+            return true;
+        }
+
+        if (target_ == nullptr || target_->write(buffer, bytes) != (int32_t)bytes) {
+            Logger::error("Error writing summary");
+            failed_ = true;
+        }
+    }
+
+    return false;
+}
+
+}
@@ -0,0 +1,63 @@
+#ifndef FK_DATA_SUMMARY_WRITER_H_INCLUDED
+#define FK_DATA_SUMMARY_WRITER_H_INCLUDED
+
+#include <lwstreams/lwstreams.h>
+
+#include "data_summary.h"
+#include "reading_block.h"
+#include "module_info.h"
+#include "tuning.h"
+
+namespace fk {
+
+/**
+ * Takes the raw bytes of the data file, as a FileCopyOperation copies them,
+ * splits them into records and reduces the readings in them to a summary
+ * that's written to the target. Records larger than our buffer are skipped,
+ * they're never readings.
+ */
+class DataSummaryWriter : public lws::Writer, public ReadingBlockVisitor {
+private:
+    DataSummary<MaximumNumberOfSensors> summary_;
+    lws::Writer *target_{ nullptr };
+    uint8_t record_[DataSummaryRecordMaximum];
+    uint32_t length_{ 0 };
+    uint8_t lengthShift_{ 0 };
+    bool body_{ false };
+    uint32_t position_{ 0 };
+    uint32_t records_{ 0 };
+    uint32_t readings_{ 0 };
+    uint32_t skipped_{ 0 };
+    bool failed_{ false };
+
+public:
+    void begin(uint32_t start, uint32_t end, uint32_t width, uint8_t sensors);
+    void target(lws::Writer &writer);
+
+    /**
+     * Called after the whole range has been copied, writes what's left of the
+     * summary. Returns true when all of it has been written.
+     */
+    bool finish();
+
+    size_t size() const {
+        return summary_.size();
+    }
+
+public:
+    int32_t write(uint8_t *ptr, size_t size) override;
+    int32_t write(uint8_t byte) override;
+    void close() override;
+
+public:
+    void reading(uint32_t number, uint8_t sensor, uint32_t time, float value) override;
+
+private:
+    void record(uint8_t *ptr, size_t size);
+    bool drain();
+
+};
+
+}
+
+#endif
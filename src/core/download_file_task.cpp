@@ -1,20 +1,52 @@
 #include "download_file_task.h"
 #include "file_system.h"
 #include "wifi_client.h"
+#include "rtc.h"
 
 namespace fk {
 
 DownloadFileTask::DownloadFileTask(FileSystem &fileSystem, CoreState &state, AppReplyMessage &reply,
-                                   MessageBuffer &buffer, WifiConnection &connection, FileCopySettings &settings) :
-    Task("DownloadFile"), fileSystem(&fileSystem), state(&state), reply(&reply), buffer(&buffer), connection(&connection), settings(settings) {
+                                   MessageBuffer &buffer, WifiConnection &connection, FileCopySettings &settings, Pool &copying) :
+    Task("DownloadFile"), fileSystem(&fileSystem), state(&state), reply(&reply), buffer(&buffer), connection(&connection), settings(settings),
+    copying(&copying) {
 }
 
 void DownloadFileTask::enqueued() {
     bytesCopied = 0;
     began = false;
-    if (!fileSystem->beginFileCopy(settings)) {
+    summary = nullptr;
+    compressor = nullptr;
+
+    // The copy clears the pool, so everything else is borrowed after.
+    if (!fileSystem->beginFileCopy(settings, *copying)) {
         log("Failed to open file");
     }
+
+    writer.begin(connection->getClient(), *copying);
+
+    if (settings.isCompressed()) {
+        compressor = copying->make<CompressingWriter>();
+        compressor->begin(writer);
+    }
+
+    if (settings.isSummary()) {
+        // Readings are logged under their index among every module's
+        // sensors, see CoreState::sensorIndex.
+        auto sensors = (uint8_t)state->numberOfSensors();
+        auto end = settings.length > 0 ? settings.length : clock.getTime();
+        summary = copying->make<DataSummaryWriter>();
+        summary->begin(settings.offset, end, settings.summaryWidth(), sensors);
+    }
+}
+
+void DownloadFileTask::fileCopyTick() {
+    // Nothing's expected from the app until the download's finished.
+}
+
+bool DownloadFileTask::fileCopyBackPressure() {
+    // Otherwise a closed connection looks like the end of the file, see
+    // task for where this ends the download.
+    return !connection->isConnected();
 }
 
 bool DownloadFileTask::writeHeader(uint32_t total) {
@@ -26,18 +58,20 @@ bool DownloadFileTask::writeHeader(uint32_t total) {
     reply->m().fileData.version = fileCopy.version();
     reply->m().fileData.id = (uint32_t)settings.file;
 
-    // TODO: Is using the buffer here necessary?
     if (!buffer->write(*reply)) {
         log("Error writing reply");
         return false;
     }
 
+    // Sent along with the metadata and the beginning of the file.
     auto size = buffer->position();
-    if (buffer->write() != size) {
+    if (writer.write(buffer->ptr(), size) != (int32_t)size) {
         log("Error sending buffer");
         return false;
     }
 
+    buffer->clear();
+
     log("Wrote header prefix (%d bytes)", size);
 
     return true;
@@ -53,8 +87,13 @@ uint32_t DownloadFileTask::calculateTotalSize(uint32_t metadataSize) {
     }
 
     if (!metadataOnly) {
-        auto &fileCopy = fileSystem->files().fileCopy();
-        size += fileCopy.remaining();
+        if (summary != nullptr) {
+            size += summary->size();
+        }
+        else {
+            auto &fileCopy = fileSystem->files().fileCopy();
+            size += fileCopy.remaining();
+        }
     }
 
     return size;
@@ -66,6 +105,11 @@ TaskEval DownloadFileTask::task() {
     auto metadataOnly = settings.flags & fk_app_DownloadFlags_DOWNLOAD_FLAG_METADATA_ONLY;
     auto prependMetadata = settings.flags & fk_app_DownloadFlags_DOWNLOAD_FLAG_METADATA_PREPEND;
 
+    if (!connection->isConnected()) {
+        log("Disconnected (%" PRIu32 " / %" PRIu32 ")", fileCopy.copied(), fileCopy.total());
+        return TaskEval::error();
+    }
+
     if (!began) {
         StaticPool<128> pool{"DataPool"};
         DataRecordMetadataMessage drm{ *state, pool };
@@ -84,8 +128,10 @@ TaskEval DownloadFileTask::task() {
         }
 
         if (prependMetadata || metadataOnly) {
-            auto &wcl = connection->getClient();
-            wcl.write(metadataBuffer, metadataSize);
+            if (body().write(metadataBuffer, metadataSize) != (int32_t)metadataSize) {
+                log("Error sending metadata");
+                return TaskEval::error();
+            }
 
             log("Wrote metadata prefix (%d bytes)", metadataSize);
 
@@ -95,14 +141,21 @@ TaskEval DownloadFileTask::task() {
         began = true;
     }
 
+    if (!metadataOnly && summary != nullptr) {
+        return summarize();
+    }
+
     if (!metadataOnly && !fileCopy.isFinished()) {
-        auto writer = WifiWriter{ connection->getClient() };
-        if (!fileCopy.copy(writer)) {
+        if (!fileCopy.copy(body(), this)) {
             log("Error copying");
             return TaskEval::error();
         }
     }
     else {
+        if (!finish()) {
+            log("Error sending");
+            return TaskEval::error();
+        }
         log("Done (%" PRIu32 " / %" PRIu32 ")", fileCopy.copied(), fileCopy.total());
         return TaskEval::done();
     }
@@ -110,4 +163,53 @@ TaskEval DownloadFileTask::task() {
     return TaskEval::idle();
 }
 
+TaskEval DownloadFileTask::summarize() {
+    auto &fileCopy = fileSystem->files().fileCopy();
+
+    summary->target(body());
+
+    // The file is copied through the summary, which writes buckets out as
+    // they're completed.
+    if (!fileCopy.isFinished()) {
+        if (!fileCopy.copy(*summary, this)) {
+            log("Error summarizing");
+            return TaskEval::error();
+        }
+        return TaskEval::idle();
+    }
+
+    if (!summary->finish() || !finish()) {
+        log("Error writing summary");
+        return TaskEval::error();
+    }
+
+    log("Done (%" PRIu32 " / %" PRIu32 ") (%d bytes)", fileCopy.copied(), fileCopy.total(), summary->size());
+
+    return TaskEval::done();
+}
+
+lws::Writer &DownloadFileTask::body() {
+    if (compressor != nullptr) {
+        return *compressor;
+    }
+    return writer;
+}
+
+bool DownloadFileTask::finish() {
+    if (compressor != nullptr) {
+        if (!compressor->finish()) {
+            return false;
+        }
+        compressor->status();
+    }
+
+    if (!writer.flush()) {
+        return false;
+    }
+
+    writer.status();
+
+    return true;
+}
+
 }
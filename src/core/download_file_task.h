@@ -7,12 +7,24 @@
 #include "wifi_client.h"
 #include "files.h"
 #include "core_state.h"
+#include "data_summary_writer.h"
+#include "compressing_writer.h"
+#include "pool.h"
 
 namespace fk {
 
 class FileSystem;
 
-class DownloadFileTask : public Task {
+/**
+ * What a DownloadFileTask needs lent, the copy's buffers and the socket
+ * buffer, and on top of that space for compressing or summarizing when the
+ * download asks for them.
+ */
+constexpr size_t DownloadFilePoolSize = FileCopyPoolSize + alignedSize(WifiSocketBufferSize);
+constexpr size_t DownloadFileCompressingSize = alignedSize(sizeof(CompressingWriter));
+constexpr size_t DownloadFileSummarizingSize = alignedSize(sizeof(DataSummaryWriter));
+
+class DownloadFileTask : public Task, public FileCopyCallbacks {
 private:
     FileSystem *fileSystem;
     CoreState *state;
@@ -20,19 +32,30 @@ private:
     MessageBuffer *buffer;
     WifiConnection *connection;
     FileCopySettings settings;
+    Pool *copying;
     uint32_t bytesCopied{ 0 };
     bool began{ false };
+    BufferedWifiWriter writer;
+    DataSummaryWriter *summary{ nullptr };
+    CompressingWriter *compressor{ nullptr };
 
 public:
-    DownloadFileTask(FileSystem &fileSystem, CoreState &state, AppReplyMessage &reply, MessageBuffer &buffer, WifiConnection &connection, FileCopySettings &settings);
+    DownloadFileTask(FileSystem &fileSystem, CoreState &state, AppReplyMessage &reply, MessageBuffer &buffer, WifiConnection &connection, FileCopySettings &settings, Pool &copying);
 
 public:
     void enqueued() override;
     TaskEval task() override;
 
+public:
+    void fileCopyTick() override;
+    bool fileCopyBackPressure() override;
+
 private:
     bool writeHeader(uint32_t size);
     uint32_t calculateTotalSize(uint32_t metadataSize);
+    TaskEval summarize();
+    lws::Writer &body();
+    bool finish();
 
 };
 
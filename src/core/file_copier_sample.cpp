@@ -6,7 +6,7 @@ FileCopierSample::FileCopierSample(FileSystem &fileSystem, CoreState &state) : T
 }
 
 void FileCopierSample::enqueued() {
-    if (!fileSystem_->beginFileCopy({ FileNumber::Data })) {
+    if (!fileSystem_->beginFileCopy({ FileNumber::Data }, copying_)) {
     }
 }
 
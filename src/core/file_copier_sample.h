@@ -11,6 +11,7 @@ class FileCopierSample : public Task {
 private:
     FileSystem *fileSystem_;
     CoreState *state_;
+    StaticPool<FileCopyPoolSize> copying_{ "FileCopy" };
 
 public:
     FileCopierSample(FileSystem &fileSystem, CoreState &state);
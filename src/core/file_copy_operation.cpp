@@ -1,3 +1,5 @@
+#include <alogging/sprintf.h>
+
 #include "file_copy_operation.h"
 #include "platform.h"
 
@@ -34,10 +36,17 @@ uint32_t FileCopyOperation::total() const {
     return total_;
 }
 
-bool FileCopyOperation::prepare(const FileReader &reader, const FileCopySettings &settings) {
+bool FileCopyOperation::prepare(const FileReader &reader, const FileCopySettings &settings, Pool &pool) {
+    if (pool.size() < FileCopyPoolSize) {
+        return false;
+    }
+
+    pool.clear();
+
     reader_ = reader;
+    reader_.readAhead(pool, FileCopyTransferSize);
 
-    streamCopier_.restart();
+    pacer_.begin();
 
     if (!reader_.open(settings.offset, settings.length)) {
         return false;
@@ -58,15 +67,16 @@ bool FileCopyOperation::copy(lws::Writer &writer, FileCopyCallbacks *callbacks)
     }
 
     auto started = fk_uptime();
-    while (fk_uptime() - started < FileCopyMaximumElapsed) {
-        auto bytes = streamCopier_.copy(reader_, writer);
-        if (bytes == 0) {
+    auto copied = (uint32_t)0;
+    while (fk_uptime() - started < pacer_.slice()) {
+        if (callbacks != nullptr && callbacks->fileCopyBackPressure()) {
+            pacer_.stalled();
+            reader_.prefetch();
             break;
         }
 
-        if (bytes > 0) {
-            copied_ += bytes;
-        }
+        auto writing = fk_uptime();
+        auto bytes = step(writer);
 
         if (bytes == lws::Stream::EOS) {
             status();
@@ -74,6 +84,16 @@ bool FileCopyOperation::copy(lws::Writer &writer, FileCopyCallbacks *callbacks)
             break;
         }
 
+        copied_ += bytes;
+        copied += bytes;
+
+        if (!pacer_.wrote(bytes, fk_uptime() - writing)) {
+            // Rather than wait on the writer, get the next chunk from the
+            // SD card ready.
+            reader_.prefetch();
+            break;
+        }
+
         if (fk_uptime() - status_ > FileCopyStatusInterval) {
             status();
             status_ = fk_uptime();
@@ -84,14 +104,51 @@ bool FileCopyOperation::copy(lws::Writer &writer, FileCopyCallbacks *callbacks)
         }
     }
 
+    pacer_.sliced(copied, fk_uptime() - started);
+
     return true;
 }
 
+int32_t FileCopyOperation::step(lws::Writer &writer) {
+    uint8_t *ptr = nullptr;
+    auto available = reader_.peek(&ptr, pacer_.chunk());
+    if (available <= 0) {
+        return lws::Stream::EOS;
+    }
+
+    auto wrote = writer.write(ptr, available);
+    if (wrote < 0) {
+        return lws::Stream::EOS;
+    }
+
+    reader_.consume(wrote);
+
+    return wrote;
+}
+
 void FileCopyOperation::status() {
     auto elapsed = fk_uptime() - started_;
     auto complete = copied_ > 0 ? ((float)copied_ / total_) * 100.0f : 0.0f;
     auto speed = copied_ > 0 ? copied_ / ((float)elapsed / 1000.0f) : 0.0f;
-    logtracef("Copy", "%lu/%lu %lums %.2f %.2fbps", copied_, total_, elapsed, complete, speed);
+    logtracef("Copy", "%lu/%lu %lums %.2f %.2fbps (chunk = %lu) (slice = %lums)",
+              copied_, total_, elapsed, complete, speed, pacer_.chunk(), pacer_.slice());
+    histogram("bps", pacer_.throughput());
+    histogram("stalls ms", pacer_.stalls());
+}
+
+/**
+ * Only buckets with something in them, as log2 of their upper bound and
+ * count, so "10:3" is three below 1024.
+ */
+void FileCopyOperation::histogram(const char *name, const Log2Histogram<FileCopyHistogramBuckets> &histogram) {
+    char buffer[FileCopyHistogramBuckets * 14] = { 0 };
+    size_t position = 0;
+    for (size_t i = 0; i < histogram.size() && position < sizeof(buffer); ++i) {
+        if (histogram.get(i) > 0) {
+            position += alogging_snprintf(buffer + position, sizeof(buffer) - position, " %d:%lu", i, histogram.get(i));
+        }
+    }
+    logtracef("Copy", "%s%s", name, buffer);
 }
 
 }
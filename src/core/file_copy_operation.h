@@ -5,6 +5,8 @@
 
 #include "data_copy_settings.h"
 #include "file_reader.h"
+#include "copy_pacer.h"
+#include "pool.h"
 #include "tuning.h"
 
 namespace fk {
@@ -12,11 +14,26 @@ namespace fk {
 class FileCopyCallbacks {
 public:
     virtual void fileCopyTick() = 0;
+
+    /**
+     * Checked between writes, returning true ends the slice early and is
+     * treated like a stalled write, for when whoever's on the other end
+     * has something that needs handling.
+     */
+    virtual bool fileCopyBackPressure() {
+        return false;
+    }
 };
 
+/**
+ * Copies a file to a writer a slice at a time, each call to copy runs for
+ * as long as the CopyPacer allows. Writes are made straight from the
+ * reader's read ahead buffers, which are only held while copying, so
+ * they're lent by whoever starts the copy.
+ */
 class FileCopyOperation {
 private:
-    lws::BufferedStreamCopier<FileCopyBufferSize> streamCopier_;
+    CopyPacer pacer_;
     uint32_t started_{ 0 };
     uint32_t status_{ 0 };
     uint32_t copied_{ 0 };
@@ -28,7 +45,12 @@ public:
     FileCopyOperation();
 
 public:
-    bool prepare(const FileReader &reader, const FileCopySettings &settings);
+    /**
+     * Clears the pool and takes FileCopyPoolSize bytes from it, so it has to
+     * last until the copy's finished or abandoned. Anything else in the pool
+     * is for whoever's being written to, allocated after this.
+     */
+    bool prepare(const FileReader &reader, const FileCopySettings &settings, Pool &pool);
     bool copy(lws::Writer &writer, FileCopyCallbacks *callbacks = nullptr);
 
 public:
@@ -40,8 +62,14 @@ public:
     uint32_t copied() const;
     uint32_t total() const;
 
+    const CopyPacer &pacer() const {
+        return pacer_;
+    }
+
 private:
+    int32_t step(lws::Writer &writer);
     void status();
+    void histogram(const char *name, const Log2Histogram<FileCopyHistogramBuckets> &histogram);
 
 };
 
@@ -0,0 +1,267 @@
+#ifndef FK_FILE_CURSOR_TABLE_H_INCLUDED
+#define FK_FILE_CURSOR_TABLE_H_INCLUDED
+
+#include <cinttypes>
+#include <cstring>
+
+#include "data_copy_settings.h"
+#include "data_index.h"
+#include "tuning.h"
+
+namespace fk {
+
+/**
+ * Base and erasing were carved from the reserved bytes, so older snapshots
+ * read as zero and the layout is unchanged.
+ */
+struct FileCursor {
+    uint32_t time{ 0 };
+    uint64_t position{ 0 };
+    uint32_t base{ 0 };
+    uint8_t erasing{ 0 };
+    uint8_t reserved[65];
+
+    FileCursor() {
+    }
+
+    FileCursor(uint32_t time, uint64_t position, uint32_t base) : time(time), position(position), base(base) {
+    }
+};
+
+/**
+ * Snapshot of every cursor, as the system file has always stored them.
+ */
+struct FileCursors {
+    FileCursor cursors[FileSystemNumberOfFiles];
+};
+
+/**
+ * Cursors as kept in RAM, along with the small records a change to a single
+ * cursor is appended to the system file as. The system file is a snapshot
+ * followed by any number of deltas, newer snapshots are appended as the
+ * deltas pile up, so the latest state is the last snapshot with the deltas
+ * after it applied. Bases change rarely and are only kept in snapshots.
+ *
+ * Delta layout, little endian:
+ *
+ *   magic      u32, FileCursorDeltaMagic
+ *   file       u8
+ *   check      u8, xor of every other byte
+ *   reserved   u16
+ *   time       u32
+ *   position   u32
+ */
+constexpr uint32_t FileCursorDeltaMagic = 0x31444346;
+constexpr size_t FileCursorDeltaSize = 16;
+
+/**
+ * The data file's index is kept in the system file alongside the deltas, in
+ * records of the same size, so it's back after a restart. A reset record
+ * starts the index over with a stride and entry records follow it in
+ * order. Snapshots are followed by a reset and every entry.
+ *
+ *   magic      u32, FileIndexResetMagic or FileIndexEntryMagic
+ *   time       u32, or stride for a reset
+ *   reading    u32
+ *   position   u32
+ */
+constexpr uint32_t FileIndexResetMagic = 0x30494446;
+constexpr uint32_t FileIndexEntryMagic = 0x31494446;
+
+enum class FileIndexRecord {
+    None,
+    Reset,
+    Entry,
+};
+
+class FileCursorTable {
+private:
+    uint32_t times_[FileSystemNumberOfFiles];
+    uint32_t positions_[FileSystemNumberOfFiles];
+    uint32_t bases_[FileSystemNumberOfFiles];
+    uint32_t erasing_{ 0 };
+    uint32_t deltas_{ 0 };
+    bool loaded_{ false };
+
+public:
+    FileCursorTable() {
+        clear();
+    }
+
+public:
+    void clear() {
+        for (size_t i = 0; i < FileSystemNumberOfFiles; ++i) {
+            times_[i] = 0;
+            positions_[i] = 0;
+            bases_[i] = 0;
+        }
+        erasing_ = 0;
+        deltas_ = 0;
+        loaded_ = false;
+    }
+
+    bool loaded() const {
+        return loaded_;
+    }
+
+    void loaded(uint32_t deltas) {
+        deltas_ = deltas;
+        loaded_ = true;
+    }
+
+    /**
+     * Deltas appended since the last snapshot.
+     */
+    uint32_t deltas() const {
+        return deltas_;
+    }
+
+    void appended() {
+        deltas_++;
+    }
+
+    void snapshotted() {
+        deltas_ = 0;
+    }
+
+    uint32_t position(FileNumber file) const {
+        return positions_[(size_t)file];
+    }
+
+    uint32_t time(FileNumber file) const {
+        return times_[(size_t)file];
+    }
+
+    /**
+     * Logical offset of the first byte still in the file, positions are
+     * logical so they stay put as the beginning of the file is dropped.
+     */
+    uint32_t base(FileNumber file) const {
+        return bases_[(size_t)file];
+    }
+
+    void base(FileNumber file, uint32_t base) {
+        bases_[(size_t)file] = base;
+    }
+
+    /**
+     * True if the file's owed an erase that hasn't finished, like bases
+     * these are only kept in snapshots.
+     */
+    bool erasing(FileNumber file) const {
+        return erasing_ & (1 << (size_t)file);
+    }
+
+    void erasing(FileNumber file, bool erasing) {
+        if (erasing) {
+            erasing_ |= 1 << (size_t)file;
+        }
+        else {
+            erasing_ &= ~(1 << (size_t)file);
+        }
+    }
+
+    void set(FileNumber file, uint32_t time, uint32_t position) {
+        times_[(size_t)file] = time;
+        positions_[(size_t)file] = position;
+    }
+
+    void restore(const FileCursors &snapshot) {
+        for (size_t i = 0; i < FileSystemNumberOfFiles; ++i) {
+            times_[i] = snapshot.cursors[i].time;
+            positions_[i] = (uint32_t)snapshot.cursors[i].position;
+            bases_[i] = snapshot.cursors[i].base;
+            erasing((FileNumber)i, snapshot.cursors[i].erasing != 0);
+        }
+    }
+
+    void snapshot(FileCursors &snapshot) const {
+        for (size_t i = 0; i < FileSystemNumberOfFiles; ++i) {
+            snapshot.cursors[i] = FileCursor{ times_[i], positions_[i], bases_[i] };
+            snapshot.cursors[i].erasing = erasing((FileNumber)i) ? 1 : 0;
+            memset(snapshot.cursors[i].reserved, 0, sizeof(snapshot.cursors[i].reserved));
+        }
+    }
+
+public:
+    static void encode(uint8_t *buffer, FileNumber file, uint32_t time, uint32_t position) {
+        put32(buffer + 0, FileCursorDeltaMagic);
+        buffer[4] = (uint8_t)file;
+        buffer[5] = 0;
+        buffer[6] = 0;
+        buffer[7] = 0;
+        put32(buffer + 8, time);
+        put32(buffer + 12, position);
+        buffer[5] = check(buffer);
+    }
+
+    static bool decode(const uint8_t *buffer, FileNumber &file, uint32_t &time, uint32_t &position) {
+        if (get32(buffer + 0) != FileCursorDeltaMagic) {
+            return false;
+        }
+        if (buffer[5] != check(buffer) || buffer[4] >= FileSystemNumberOfFiles) {
+            return false;
+        }
+        file = (FileNumber)buffer[4];
+        time = get32(buffer + 8);
+        position = get32(buffer + 12);
+        return true;
+    }
+
+    static void encodeIndexReset(uint8_t *buffer, uint32_t stride) {
+        put32(buffer + 0, FileIndexResetMagic);
+        put32(buffer + 4, stride);
+        put32(buffer + 8, 0);
+        put32(buffer + 12, 0);
+    }
+
+    static void encodeIndexEntry(uint8_t *buffer, const DataIndexEntry &entry) {
+        put32(buffer + 0, FileIndexEntryMagic);
+        put32(buffer + 4, entry.time);
+        put32(buffer + 8, entry.reading);
+        put32(buffer + 12, entry.position);
+    }
+
+    static FileIndexRecord decodeIndex(const uint8_t *buffer, uint32_t &stride, DataIndexEntry &entry) {
+        switch (get32(buffer + 0)) {
+        case FileIndexResetMagic:
+            stride = get32(buffer + 4);
+            return stride > 0 ? FileIndexRecord::Reset : FileIndexRecord::None;
+        case FileIndexEntryMagic:
+            entry = DataIndexEntry{ get32(buffer + 4), get32(buffer + 8), get32(buffer + 12) };
+            return FileIndexRecord::Entry;
+        default:
+            return FileIndexRecord::None;
+        }
+    }
+
+private:
+    static uint8_t check(const uint8_t *buffer) {
+        uint8_t value = 0;
+        for (size_t i = 0; i < FileCursorDeltaSize; ++i) {
+            if (i != 5) {
+                value ^= buffer[i];
+            }
+        }
+        return value;
+    }
+
+    static void put32(uint8_t *ptr, uint32_t value) {
+        for (auto i = 0; i < 4; ++i) {
+            ptr[i] = (uint8_t)(value >> (i * 8));
+        }
+    }
+
+    static uint32_t get32(const uint8_t *ptr) {
+        uint32_t value = 0;
+        for (auto i = 0; i < 4; ++i) {
+            value |= (uint32_t)ptr[i] << (i * 8);
+        }
+        return value;
+    }
+
+};
+
+}
+
+#endif
@@ -10,69 +10,333 @@ using Logger = SimpleLog<LogName>;
 FileCursorManager::FileCursorManager(FileSystem &fileSystem) : fileSystem_(&fileSystem) {
 }
 
-bool FileCursorManager::lookup(FileCursors &cursors) {
-    auto file = fileSystem_->openSystem(phylum::OpenMode::Read);
-    auto size = file.size();
+uint64_t FileCursorManager::lookup(FileNumber file) {
+    fk_assert((size_t)file < FileSystemNumberOfFiles);
 
-    if (size < sizeof(FileCursors)) {
-        cursors = { };
-        return true;
+    if (!load()) {
+        return 0;
     }
 
-    auto position = file.size() - sizeof(FileCursors);
-    if (!file.seek(position)) {
-        Logger::warn("Unable to seek (position = %lu) (size = %lu) (sizeof() = %d)",
-                     (uint32_t)position, (uint32_t)file.size(), sizeof(FileCursors));
+    return fileSystem_->cursors().position(file);
+}
+
+bool FileCursorManager::save(FileNumber file, uint64_t position) {
+    fk_assert((size_t)file < FileSystemNumberOfFiles);
+
+    if (!load()) {
         return false;
     }
 
-    if (file.read((uint8_t *)&cursors, sizeof(FileCursors)) != sizeof(FileCursors)) {
-        Logger::warn("Unable to read");
+    auto &table = fileSystem_->cursors();
+
+    table.set(file, clock.getTime(), (uint32_t)position);
+
+    if (table.deltas() >= FileCursorDeltasPerSnapshot) {
+        return appendSnapshot();
+    }
+
+    return appendDelta(file);
+}
+
+uint32_t FileCursorManager::base(FileNumber file) {
+    fk_assert((size_t)file < FileSystemNumberOfFiles);
+
+    if (!load()) {
+        return 0;
+    }
+
+    return fileSystem_->cursors().base(file);
+}
+
+bool FileCursorManager::rebase(FileNumber file, uint32_t base) {
+    fk_assert((size_t)file < FileSystemNumberOfFiles);
+
+    if (!load()) {
         return false;
     }
 
+    auto &table = fileSystem_->cursors();
+
+    table.base(file, base);
+    table.set(file, clock.getTime(), base);
+
+    return appendSnapshot();
+}
+
+bool FileCursorManager::beginErase(FileNumber file, uint32_t base) {
+    fk_assert((size_t)file < FileSystemNumberOfFiles);
+
+    if (!load()) {
+        return false;
+    }
+
+    fileSystem_->cursors().erasing(file, true);
+
+    return rebase(file, base);
+}
+
+bool FileCursorManager::endErase(FileNumber file) {
+    fk_assert((size_t)file < FileSystemNumberOfFiles);
+
+    if (!load()) {
+        return false;
+    }
+
+    auto &table = fileSystem_->cursors();
+    if (!table.erasing(file)) {
+        return true;
+    }
+
+    table.erasing(file, false);
+
+    return appendSnapshot();
+}
+
+bool FileCursorManager::load() {
+    auto &table = fileSystem_->cursors();
+    if (table.loaded()) {
+        return true;
+    }
+
+    auto file = fileSystem_->openSystem(phylum::OpenMode::Read);
+    auto size = (uint32_t)file.size();
+    auto position = size;
+    auto records = (uint32_t)0;
+    bool seen[FileSystemNumberOfFiles] = { false };
+    uint32_t times[FileSystemNumberOfFiles];
+    uint32_t positions[FileSystemNumberOfFiles];
+
+    // Walk back over the deltas and index records, the first delta we come
+    // to for a file is the newest. The snapshot they're based on comes
+    // before them.
+    while (position >= FileCursorDeltaSize) {
+        uint8_t buffer[FileCursorDeltaSize];
+        if (!file.seek(position - FileCursorDeltaSize)) {
+            break;
+        }
+        if (file.read(buffer, sizeof(buffer)) != sizeof(buffer)) {
+            break;
+        }
+
+        FileNumber number;
+        uint32_t time;
+        uint32_t cursor;
+        uint32_t stride;
+        DataIndexEntry entry;
+        if (FileCursorTable::decode(buffer, number, time, cursor)) {
+            auto i = (size_t)number;
+            if (!seen[i]) {
+                seen[i] = true;
+                times[i] = time;
+                positions[i] = cursor;
+            }
+        }
+        else if (FileCursorTable::decodeIndex(buffer, stride, entry) == FileIndexRecord::None) {
+            break;
+        }
+
+        position -= FileCursorDeltaSize;
+        records++;
+    }
+
+    table.clear();
+
+    if (position >= sizeof(FileCursors)) {
+        FileCursors snapshot;
+        if (!file.seek(position - sizeof(FileCursors))) {
+            Logger::warn("Unable to seek (position = %lu) (size = %lu) (sizeof() = %d)",
+                         position, size, sizeof(FileCursors));
+            return false;
+        }
+
+        if (file.read((uint8_t *)&snapshot, sizeof(FileCursors)) != sizeof(FileCursors)) {
+            Logger::warn("Unable to read");
+            return false;
+        }
+
+        table.restore(snapshot);
+    }
+
+    for (size_t i = 0; i < FileSystemNumberOfFiles; ++i) {
+        if (seen[i]) {
+            table.set((FileNumber)i, times[i], positions[i]);
+        }
+    }
+
+    // The index is replayed forwards, a reset starts it over. Those right
+    // after the snapshot were written with it and don't count as deltas.
+    auto &index = fileSystem_->logging().index();
+    auto reset = false;
+    auto snapshotted = (uint32_t)0;
+    auto following = false;
+
+    index.clear();
+
+    for (auto i = position; i + FileCursorDeltaSize <= size; i += FileCursorDeltaSize) {
+        uint8_t buffer[FileCursorDeltaSize];
+        if (!file.seek(i) || file.read(buffer, sizeof(buffer)) != sizeof(buffer)) {
+            Logger::warn("Unable to read index (position = %lu)", i);
+            index.clear();
+            reset = false;
+            break;
+        }
+
+        uint32_t stride;
+        DataIndexEntry entry;
+        switch (FileCursorTable::decodeIndex(buffer, stride, entry)) {
+        case FileIndexRecord::Reset:
+            following = i == position;
+            index.clear(stride);
+            reset = true;
+            break;
+        case FileIndexRecord::Entry:
+            index.restore(entry);
+            break;
+        default:
+            following = false;
+            break;
+        }
+
+        if (following) {
+            snapshotted++;
+        }
+    }
+
+    // Entries past the end of the data file are from before it was erased
+    // and the reset never made it out.
+    auto dataSize = (uint32_t)fileSystem_->files().data().size();
+    if (index.size() > 0 && index.get(index.size() - 1).position > dataSize) {
+        Logger::warn("Index is stale (position = %lu) (size = %lu)", index.get(index.size() - 1).position, dataSize);
+        index.clear();
+        reset = false;
+    }
+
+    if (reset) {
+        index.markSaved();
+    }
+
+    index.advance(clock.getTime());
+
+    table.loaded(records - snapshotted);
+
+    Logger::info("Loaded cursors (%lu records) (%d indexed) (size = %lu)", records, index.size(), size);
+
     return true;
 }
 
-bool FileCursorManager::save(FileCursors cursors) {
-    auto file = fileSystem_->openSystem(phylum::OpenMode::Write);
+bool FileCursorManager::saveIndex() {
+    if (!load()) {
+        return false;
+    }
+
+    auto &index = fileSystem_->logging().index();
+    if (!index.dirty()) {
+        return true;
+    }
 
-    auto status = file.write((uint8_t *)&cursors, sizeof(FileCursors));
+    if (fileSystem_->cursors().deltas() >= FileCursorDeltasPerSnapshot) {
+        return appendSnapshot();
+    }
 
-    file.close();
+    auto system = fileSystem_->openSystem(phylum::OpenMode::Write);
+    auto success = appendIndex(system, false);
+    system.close();
 
-    return status;
+    return success;
 }
 
-uint64_t FileCursorManager::lookup(FileNumber file) {
-    FileCursors cursors;
+bool FileCursorManager::appendIndex(phylum::SimpleFile &system, bool everything) {
+    auto &table = fileSystem_->cursors();
+    auto &index = fileSystem_->logging().index();
+    auto first = index.saved();
 
-    fk_assert((size_t)file < FileSystemNumberOfFiles);
+    uint8_t buffer[FileCursorDeltaSize];
 
-    if (!lookup(cursors)) {
-        return 0;
+    if (everything || index.rewrite()) {
+        FileCursorTable::encodeIndexReset(buffer, index.stride());
+        if (system.write(buffer, sizeof(buffer)) != sizeof(buffer)) {
+            return false;
+        }
+        if (!everything) {
+            table.appended();
+        }
+        first = 0;
     }
 
-    return cursors.cursors[(size_t)file].position;
+    for (auto i = first; i < index.size(); ++i) {
+        FileCursorTable::encodeIndexEntry(buffer, index.get(i));
+        if (system.write(buffer, sizeof(buffer)) != sizeof(buffer)) {
+            return false;
+        }
+        if (!everything) {
+            table.appended();
+        }
+    }
+
+    index.markSaved();
+
+    return true;
 }
 
-bool FileCursorManager::save(FileNumber file, uint64_t position) {
-    FileCursors cursors;
+bool FileCursorManager::appendDelta(FileNumber file) {
+    auto &table = fileSystem_->cursors();
 
-    fk_assert((size_t)file < FileSystemNumberOfFiles);
+    uint8_t buffer[FileCursorDeltaSize];
+    FileCursorTable::encode(buffer, file, table.time(file), table.position(file));
 
-    if (!lookup(cursors)) {
+    auto system = fileSystem_->openSystem(phylum::OpenMode::Write);
+    auto written = system.write(buffer, sizeof(buffer));
+    system.close();
+
+    if (written != sizeof(buffer)) {
         return false;
     }
 
-    cursors.cursors[(size_t)file] = { clock.getTime(), position };
+    table.appended();
+
+    return true;
+}
+
+bool FileCursorManager::appendSnapshot() {
+    auto &table = fileSystem_->cursors();
+
+    FileCursors snapshot;
+    table.snapshot(snapshot);
+
+    auto size = (uint32_t)fileSystem_->openSystem(phylum::OpenMode::Read).size();
+    auto compacting = size + sizeof(FileCursors) + FileCursorCompactLeadBlocks * fileSystem_->blockSize() > fileSystem_->maximumSize(FileNumber::System);
 
-    if (!save(cursors)) {
+    // Always appended first, the lead blocks leave room for it, so the
+    // cursors and bases are on the card before anything's erased.
+    if (!writeSnapshot(snapshot)) {
         return false;
     }
 
+    if (compacting) {
+        // The snapshot has everything, so the file can start over.
+        Logger::info("Compacting system file (size = %lu)", size);
+        if (!fileSystem_->fs().erase(fileSystem_->files().file((size_t)FileNumber::System))) {
+            Logger::error("Unable to erase system file");
+            return false;
+        }
+
+        if (!writeSnapshot(snapshot)) {
+            return false;
+        }
+    }
+
+    table.snapshotted();
+
     return true;
 }
 
+bool FileCursorManager::writeSnapshot(FileCursors &snapshot) {
+    auto system = fileSystem_->openSystem(phylum::OpenMode::Write);
+    auto written = system.write((uint8_t *)&snapshot, sizeof(FileCursors));
+    auto indexed = written == sizeof(FileCursors) && appendIndex(system, true);
+    system.close();
+
+    return indexed;
+}
 
 }
@@ -2,25 +2,16 @@
 #define FK_FILE_CURSORS_H_INCLUDED
 
 #include "file_system.h"
+#include "file_cursor_table.h"
 
 namespace fk {
 
-struct FileCursor {
-    uint32_t time{ 0 };
-    uint64_t position{ 0 };
-    uint8_t reserved[70];
-
-    FileCursor() {
-    }
-
-    FileCursor(uint32_t time, uint64_t position) : time(time), position(position) {
-    }
-};
-
-struct FileCursors {
-    FileCursor cursors[FileSystemNumberOfFiles];
-};
-
+/**
+ * Cursors are read from the system file once after boot and kept in the
+ * FileSystem's FileCursorTable, saving one appends a small delta record and
+ * only occasionally a whole snapshot, see file_cursor_table.h. The data
+ * file's index is kept there too.
+ */
 class FileCursorManager {
 private:
     FileSystem *fileSystem_;
@@ -28,14 +19,46 @@ private:
 public:
     FileCursorManager(FileSystem &fileSystem);
 
-public:
-    bool lookup(FileCursors &cursors);
-    bool save(FileCursors cursors);
-
 public:
     uint64_t lookup(FileNumber file);
     bool save(FileNumber file, uint64_t position);
 
+    /**
+     * Logical offset of the beginning of the file, see FileCursorTable.
+     */
+    uint32_t base(FileNumber file);
+
+    /**
+     * Records that the file now begins at base, after it's been erased, and
+     * moves the cursor there. Always written as a snapshot.
+     */
+    bool rebase(FileNumber file, uint32_t base);
+
+    /**
+     * Like rebase, and also records that the file's owed an erase so that a
+     * reset before endErase finishes it at boot, see FileSystem::setup.
+     */
+    bool beginErase(FileNumber file, uint32_t base);
+    bool endErase(FileNumber file);
+
+    /**
+     * Reads the cursors and the data file's index, if they haven't been
+     * already. Done at mount so the index is back before anything's logged.
+     */
+    bool load();
+
+    /**
+     * Appends index entries added since the last save, or the whole index
+     * if it's been cleared or thinned out since.
+     */
+    bool saveIndex();
+
+private:
+    bool appendIndex(phylum::SimpleFile &system, bool everything);
+    bool appendDelta(FileNumber file);
+    bool appendSnapshot();
+    bool writeSnapshot(FileCursors &snapshot);
+
 };
 
 }
@@ -3,6 +3,7 @@
 #include "file_system.h"
 #include "file_cursors.h"
 #include "rtc.h"
+#include "configuration.h"
 
 using namespace phylum;
 
@@ -16,6 +17,10 @@ using Logger = SimpleLog<Log>;
 
 extern "C" {
 
+static bool is_flash(const char *ptr) {
+    return ptr != nullptr && (uintptr_t)ptr < Hardware::FLASH_END;
+}
+
 static uint32_t log_uptime() {
     return clock.getTime();
 }
@@ -25,6 +30,13 @@ static size_t debug_write_log(const LogMessage *m, const char *fstring, va_list
         return 0;
     }
 
+    // Formatting is left for later so long as the strings will still be
+    // there, which they won't be if they're not in flash.
+    if (configuration.logging.binary && is_flash(fstring) && is_flash(m->facility)) {
+        global_files->binaryLog().append(m->uptime, m->time, m->level, m->facility, fstring, args);
+        return 0;
+    }
+
     if (!Hardware::peripheralsEnabled()) {
         return 0;
     }
@@ -45,8 +57,12 @@ static size_t debug_write_log(const LogMessage *m, const char *fstring, va_list
 
     auto &log = global_files->log();
     if (log) {
-        int32_t bytes = stream.bytes_written;
-        if (log.write(buffer, bytes, true) != bytes) {
+        // Binary entries waiting in the ring came first.
+        if (!global_files->commitBinaryLog()) {
+            log_uart_get()->println("Unable to append binary log");
+        }
+
+        if (!global_files->stagedLog().append(buffer, stream.bytes_written)) {
             log_uart_get()->println("Unable to append log");
             global_files->error();
             return 0;
@@ -75,6 +91,8 @@ bool FileSystem::formatAll() {
 
     formatted_ = true;
 
+    files_.invalidateAll();
+
     if (!storage_.initialize(g_, Hardware::SD_PIN_CS)) {
         Logger::error("Unable to initialize SD.");
         return false;
@@ -96,19 +114,14 @@ bool FileSystem::formatAll() {
 bool FileSystem::eraseAll() {
     auto success = true;
 
-    closeSystemFiles();
+    Logger::info("Erasing all files");
 
-    for (auto &fd : files_.descriptors_) {
-        if (!fs_.erase(*fd)) {
+    for (size_t i = 0; i < FileSystemNumberOfFiles; ++i) {
+        if (!erase((FileNumber)i)) {
             success = false;
-            Logger::error("Erase failed: %s", fd->name);
         }
     }
 
-    if (!openSystemFiles()) {
-        return false;
-    }
-
     return success;
 }
 
@@ -144,6 +157,21 @@ bool FileSystem::setup() {
         }
     }
 
+    // Before anything's logged, so the data file's index carries on. Erases
+    // that were pending are finished from idle, which gets to them before
+    // any readings are taken.
+    FileCursorManager fcm(*this);
+    if (!fcm.load()) {
+        Logger::error("Unable to load cursors");
+    }
+
+    for (size_t i = 0; i < FileSystemNumberOfFiles; ++i) {
+        if (cursors_.erasing((FileNumber)i)) {
+            Logger::info("Resuming erase of %s", files_.descriptors_[i]->name);
+            erasing_ |= 1 << i;
+        }
+    }
+
     log_configure_time(fk_uptime, log_uptime);
     log_configure_hook_register(debug_write_log, nullptr);
     log_configure_hook(true);
@@ -152,12 +180,20 @@ bool FileSystem::setup() {
 }
 
 bool FileSystem::closeSystemFiles() {
+    files_.commitBinaryLog();
+    files_.stagedLog_.commit();
+    files_.stagedData_.commit();
+
     if (files_.log_) {
         files_.log_.close();
     }
+    if (files_.standby_) {
+        files_.standby_.close();
+    }
     if (files_.data_) {
         files_.data_.close();
     }
+    storage_.flush();
     return true;
 }
 
@@ -178,14 +214,32 @@ static SimpleFile open_file_or_truncate(FileOpener &opener, phylum::FileDescript
 }
 
 bool FileSystem::openSystemFiles() {
-    auto logs_a = open_file_or_truncate(fs_, files_.file_logs_a_fd);
-    if (!logs_a) {
-        return false;
+    // Opening a file walks its blocks to find the end, which is most of the
+    // time spent mounting, so each file is opened once and we stop at the
+    // first log with room. If they're all full the first swap moves us
+    // along.
+    files_.log_ = { };
+    files_.standby_ = { };
+
+    phylum::SimpleFile first;
+    for (auto fd : files_.logs_) {
+        auto log = open_file_or_truncate(fs_, *fd);
+        if (!log) {
+            return false;
+        }
+
+        if (!log.in_final_block()) {
+            files_.log_ = log;
+            break;
+        }
+
+        if (!first) {
+            first = log;
+        }
     }
 
-    auto logs_b = open_file_or_truncate(fs_, files_.file_logs_b_fd);
-    if (!logs_b) {
-        return false;
+    if (!files_.log_) {
+        files_.log_ = first;
     }
 
     auto data = open_file_or_truncate(fs_, files_.file_data_fk);
@@ -195,26 +249,59 @@ bool FileSystem::openSystemFiles() {
 
     files_.data_ = data;
 
+    // Sizes of the files we just opened, rather than opening them again.
+    auto &log = files_.log_;
+    Logger::info("File: %s size = %lu maximum = %lu", log.fd().name, (uint32_t)log.size(), (uint32_t)log.fd().maximum_size);
+    Logger::info("File: %s size = %lu", data.fd().name, (uint32_t)data.size());
 
-    if (logs_a.in_final_block()) {
-        files_.log_ = logs_b;
-    }
-    else {
-        files_.log_ = logs_a;
+    return true;
+}
+
+bool FileSystem::erase(FileNumber number) {
+    fk_assert((size_t)number < FileSystemNumberOfFiles);
+
+    erasing_ |= 1 << (size_t)number;
+
+    Logger::info("Erasing %s", files_.descriptors_[(size_t)number]->name);
+
+    // So a reset before we get to it still erases the file.
+    FileCursorManager fcm(*this);
+    if (!fcm.beginErase(number, 0)) {
+        Logger::error("Unable to save erase: %s", files_.descriptors_[(size_t)number]->name);
+        return false;
     }
 
-    // Report file size information.
-    for (auto fd : files_.descriptors_) {
-        auto opened = fs_.open(*fd);
-        if (opened) {
-            Logger::info("File: %s size = %lu maximum = %lu", fd->name, (uint32_t)opened.size(), (uint32_t)fd->maximum_size);
+    return true;
+}
+
+bool FileSystem::erasing(FileNumber number) const {
+    return erasing_ & (1 << (size_t)number);
+}
+
+bool FileSystem::eraseNext() {
+    // Backwards, so the data file goes first, before any readings are
+    // logged to it, and the system file last as it records the others.
+    for (size_t i = FileSystemNumberOfFiles; i > 0; --i) {
+        auto number = (FileNumber)(i - 1);
+        if (erasing(number)) {
+            if (!eraseNow(number)) {
+                return false;
+            }
+
+            FileCursorManager fcm(*this);
+            if (!fcm.endErase(number)) {
+                Logger::error("Unable to save erase: %s", files_.descriptors_[i - 1]->name);
+            }
+
+            Logger::info("Erased %s (%d remaining)", files_.descriptors_[i - 1]->name, erasing());
+
+            return true;
         }
     }
-
     return true;
 }
 
-bool FileSystem::erase(FileNumber number) {
+bool FileSystem::eraseNow(FileNumber number) {
     auto fd = files_.descriptors_[(size_t)number];
     auto success = true;
 
@@ -225,6 +312,20 @@ bool FileSystem::erase(FileNumber number) {
         Logger::error("Erase failed: %s", fd->name);
     }
 
+    if (number == FileNumber::Data) {
+        data_.erased();
+    }
+
+    if (number == FileNumber::System) {
+        cursors_.clear();
+        cursors_.loaded(0);
+        data_.index().markUnsaved();
+    }
+
+    erasing_ &= ~(1 << (size_t)number);
+
+    files_.invalidate(*fd);
+
     if (!openSystemFiles()) {
         return false;
     }
@@ -232,7 +333,46 @@ bool FileSystem::erase(FileNumber number) {
     return success;
 }
 
-bool FileSystem::beginFileCopy(FileCopySettings settings) {
+uint32_t FileSystem::base(FileNumber number) {
+    FileCursorManager fcm(*this);
+    return fcm.base(number);
+}
+
+bool FileSystem::dropUploaded(FileNumber number) {
+    if (number != FileNumber::Data || !configuration.storage.drop_uploaded) {
+        return true;
+    }
+
+    FileCursorManager fcm(*this);
+    auto base = fcm.base(number);
+    auto acknowledged = (uint32_t)fcm.lookup(number);
+    auto size = files_.stagedData_.tell();
+
+    if (size < DataSegmentSize || acknowledged < base + size) {
+        return true;
+    }
+
+    Logger::info("Dropping uploaded segment (%lu bytes) (base = %lu)", size, base);
+
+    // The new base goes out before the erase, along with the erase being
+    // owed, so a reset part way through finishes it rather than losing both.
+    if (!fcm.beginErase(number, base + size)) {
+        Logger::error("Unable to save base: %lu", base + size);
+        return false;
+    }
+
+    if (!eraseNow(number)) {
+        return false;
+    }
+
+    if (!fcm.endErase(number)) {
+        Logger::error("Unable to save erase: %s", files_.descriptors_[(size_t)number]->name);
+    }
+
+    return true;
+}
+
+bool FileSystem::beginFileCopy(FileCopySettings settings, Pool &pool) {
     auto fd = files_.descriptors_[(size_t)settings.file];
 
     files_.opened_ = fs_.open(*fd, OpenMode::Read);
@@ -240,8 +380,31 @@ bool FileSystem::beginFileCopy(FileCopySettings settings) {
         return false;
     }
 
+    if (erasing(settings.file)) {
+        // The file's logically empty until idle gets to the erase, so copy
+        // nothing rather than erasing in the middle of the request.
+        Logger::info("Copy of %s while erasing (%d remaining)", fd->name, erasing());
+        settings.offset = files_.opened_.size();
+        settings.length = 0;
+    }
+    else if (settings.isTimeRange()) {
+        settings = resolveTimeRange(settings);
+    }
+    else {
+        // Offsets from the app and cursors are logical, anything before the
+        // base has been dropped.
+        auto base = this->base(settings.file);
+        if (settings.offset < base) {
+            Logger::warn("Offset before base (offset = %lu) (base = %lu)", settings.offset, base);
+            settings.offset = 0;
+        }
+        else {
+            settings.offset -= base;
+        }
+    }
+
     auto newReader = FileReader{ files_.opened_ };
-    if (!files_.fileCopy_.prepare(newReader, settings)) {
+    if (!files_.fileCopy_.prepare(newReader, settings, pool)) {
         return false;
     }
 
@@ -253,12 +416,64 @@ bool FileSystem::beginFileCopy(FileCopySettings settings) {
     return true;
 }
 
-bool FileSystem::flush() {
+FileCopySettings FileSystem::resolveTimeRange(FileCopySettings settings) {
+    auto start = settings.offset;
+    auto end = settings.length;
+
+    settings.flags &= ~(FileCopyFlagTimeRange | FileCopyFlagSummary);
+    settings.offset = 0;
+    settings.length = 0;
+
+    // Only the data file is indexed, anything else is copied in full.
+    if (settings.file != FileNumber::Data) {
+        return settings;
+    }
+
+    auto &index = data_.index();
+
+    // Buffered readings can be logged after ones later than them, though
+    // never by more than they're allowed to be old.
+    settings.offset = index.begin(start);
+    if (end > 0 && end < UINT32_MAX - BufferedReadingsMaximumAge) {
+        auto position = index.end(end + BufferedReadingsMaximumAge);
+        if (position > settings.offset) {
+            settings.length = position - settings.offset;
+        }
+    }
+
+    Logger::info("Time range %lu - %lu is %lu + %lu (%d entries, stride %lu)",
+                 start, end, settings.offset, settings.length, index.size(), index.stride());
+
+    return settings;
+}
+
+bool FileSystem::flush(CommitPoint point) {
     if (!Hardware::peripheralsEnabled()) {
         Logger::trace("No flush, peripherals disabled.");
         return 0;
     }
 
+    if (!shouldCommit(point)) {
+        return true;
+    }
+
+    if (!files_.commitBinaryLog()) {
+        return false;
+    }
+
+    if (!files_.stagedData_.commit()) {
+        return false;
+    }
+
+    if (!files_.commitLog()) {
+        return false;
+    }
+
+    auto &data = files_.stagedData_.statistics();
+    auto &log = files_.stagedLog_.statistics();
+    Logger::trace("Committed data %lu/%lu bytes in %lu, log %lu/%lu bytes in %lu",
+                  data.committed, data.staged, data.commits, log.committed, log.staged, log.commits);
+
     if (!files_.log_.flush()) {
         return false;
     }
@@ -267,15 +482,163 @@ bool FileSystem::flush() {
         return false;
     }
 
+    // Only once the records the entries point at are committed.
+    if (data_.index().dirty()) {
+        FileCursorManager fcm(*this);
+        if (!fcm.saveIndex()) {
+            Logger::error("Unable to save index");
+        }
+    }
+
+    if (!storage_.flush()) {
+        return false;
+    }
+
+    auto &cache = storage_.cache().statistics();
+    Logger::trace("Cache hits %lu misses %lu bypassed %lu evictions %lu writebacks %lu batched %lu runs %lu",
+                  cache.hits, cache.misses, cache.bypassed, cache.evictions, cache.writebacks, cache.batched, cache.runs);
+
     files_.checkErrors();
 
     return true;
 }
 
+bool FileSystem::task() {
+    // Staged appends are otherwise only checked for age as more come in,
+    // so a quiet spell would leave them in RAM.
+    if (files_.stagedData_.due() || files_.stagedLog_.due()) {
+        if (!flush(CommitPoint::Always)) {
+            Logger::error("Unable to commit staged appends");
+        }
+    }
+
+    auto &binary = files_.binaryLog();
+    if (binary.entries() == 0 && binary.dropped() == 0) {
+        return true;
+    }
+
+    if (binary.size() < BinaryLogCommitSize && fk_uptime() - binary.oldest() < BinaryLogMaximumAge) {
+        return true;
+    }
+
+    if (!Hardware::peripheralsEnabled()) {
+        return true;
+    }
+
+    return files_.commitBinaryLog();
+}
+
+bool FileSystem::idle() {
+    // One file per call, so the loop and the watchdog get a turn between
+    // them. Everything else waits until they're done.
+    if (erasing_ != 0) {
+        if (!eraseNext()) {
+            Logger::error("Erase failed");
+            return false;
+        }
+
+        if (erasing_ == 0) {
+            replies_.erased();
+        }
+
+        return true;
+    }
+
+    if (!prepareStandbyLogIfNecessary()) {
+        Logger::error("Unable to prepare standby log");
+        return false;
+    }
+
+    return true;
+}
+
+bool FileSystem::prepareStandbyLogIfNecessary() {
+    if (!files_.log_ || files_.hasStandbyLog()) {
+        return true;
+    }
+
+    if (!Hardware::peripheralsEnabled()) {
+        return true;
+    }
+
+    auto &fd = files_.log_.fd();
+    auto maximum = (uint32_t)fd.maximum_size * blockSize();
+    auto lead = LogStandbyLeadBlocks * blockSize();
+    if ((uint32_t)files_.log_.size() + lead < maximum) {
+        return true;
+    }
+
+    Logger::info("Preparing standby log (%s %lu/%lu)", fd.name, (uint32_t)files_.log_.size(), maximum);
+
+    return files_.prepareStandbyLog();
+}
+
+uint32_t FileSystem::blockSize() const {
+    return (uint32_t)g_.pages_per_block * g_.sectors_per_page * g_.sector_size;
+}
+
+uint32_t FileSystem::maximumSize(FileNumber number) const {
+    return (uint32_t)files_.file((size_t)number).maximum_size * blockSize();
+}
+
+bool FileSystem::shouldCommit(CommitPoint point) const {
+    auto &storage = configuration.storage;
+
+    switch (point) {
+    case CommitPoint::Readings: return storage.commit_after_readings;
+    case CommitPoint::Sleep: return storage.commit_before_sleep;
+    case CommitPoint::Wifi: return storage.commit_before_wifi;
+    default: return true;
+    }
+}
+
 phylum::SimpleFile FileSystem::openSystem(phylum::OpenMode mode) {
+    if (mode != OpenMode::Read) {
+        files_.invalidate(files_.file_system_area_fd);
+    }
     return fs_.open(files_.file_system_area_fd, mode);
 }
 
+CachedStat FileSystem::stat(FileNumber number) {
+    auto i = (size_t)number;
+    auto &fd = *files_.descriptors_[i];
+
+    if (!(files_.statted_ & (1 << i))) {
+        auto stat = fs_.stat(fd);
+        files_.stats_[i] = CachedStat{ (uint64_t)stat.size, (uint32_t)stat.version };
+        files_.statted_ |= 1 << i;
+    }
+
+    auto cached = files_.stats_[i];
+
+    // Open files are appended to all the time, they know their own size.
+    if (files_.data_ && &files_.data_.fd() == &fd) {
+        cached.size = files_.data_.size();
+    }
+    else if (files_.log_ && &files_.log_.fd() == &fd) {
+        cached.size = files_.log_.size();
+    }
+    else if (files_.standby_ && &files_.standby_.fd() == &fd) {
+        cached.size = files_.standby_.size();
+    }
+
+    if (configuration.storage.validate_file_stats) {
+        auto stat = fs_.stat(fd);
+        if ((uint64_t)stat.size != cached.size || (uint32_t)stat.version != cached.version) {
+            Logger::warn("Stale stat: %s (size = %lu/%lu) (version = %lu/%lu)", fd.name,
+                         (uint32_t)cached.size, (uint32_t)stat.size, cached.version, (uint32_t)stat.version);
+            cached = CachedStat{ (uint64_t)stat.size, (uint32_t)stat.version };
+            files_.stats_[i] = cached;
+        }
+    }
+
+    if (erasing(number)) {
+        cached.size = 0;
+    }
+
+    return cached;
+}
+
 Files::Files(phylum::FileOpener &files) : files_(&files) {
     global_files = this;
 }
@@ -297,40 +660,119 @@ bool Files::swapLogsIfNecessary() {
         return true;
     }
 
-    auto new_fd = &file_logs_a_fd;
-    if (&log_.fd() == &file_logs_a_fd) {
-        new_fd = &file_logs_b_fd;
+    // Normally done ahead of time, this is the slow path for when the log
+    // filled up before we got the chance.
+    if (!standby_ && !prepareStandbyLog()) {
+        return false;
     }
 
-    if (!files_->erase(*new_fd)) {
-        return false;
+    log_.close();
+
+    log_ = standby_;
+    standby_ = { };
+
+    return true;
+}
+
+bool Files::prepareStandbyLog() {
+    if (standby_) {
+        return true;
     }
 
-    auto other = files_->open(*new_fd, phylum::OpenMode::MultipleWrites);
-    if (!other) {
+    auto next = logs_[0];
+    for (size_t i = 0; i < FileSystemNumberOfLogs; ++i) {
+        if (&log_.fd() == logs_[i]) {
+            next = logs_[(i + 1) % FileSystemNumberOfLogs];
+        }
+    }
+
+    if (!files_->erase(*next)) {
         return false;
     }
 
-    log_.close();
+    invalidate(*next);
 
-    log_ = other;
+    standby_ = files_->open(*next, phylum::OpenMode::MultipleWrites);
+    if (!standby_) {
+        return false;
+    }
 
     return true;
 }
 
+bool Files::hasStandbyLog() {
+    return standby_ ? true : false;
+}
+
+void Files::invalidate(phylum::FileDescriptor &fd) {
+    for (size_t i = 0; i < FileSystemNumberOfFiles; ++i) {
+        if (descriptors_[i] == &fd) {
+            statted_ &= ~(1 << i);
+        }
+    }
+}
+
+void Files::invalidateAll() {
+    statted_ = 0;
+}
+
 phylum::SimpleFile &Files::log() {
     return log_;
 }
 
+StagedFile &Files::stagedData() {
+    return stagedData_;
+}
+
+StagedFile &Files::stagedLog() {
+    return stagedLog_;
+}
+
+BinaryLog &Files::binaryLog() {
+    return binaryLog_;
+}
+
+bool Files::commitBinaryLog() {
+    if (binaryLog_.entries() == 0 && binaryLog_.dropped() == 0) {
+        return true;
+    }
+
+    if (!log_) {
+        return false;
+    }
+
+    size_t size = 0;
+    auto record = binaryLog_.record(size);
+    auto success = stagedLog_.append(record, size);
+
+    binaryLog_.clear();
+
+    if (!success) {
+        return false;
+    }
+
+    return swapLogsIfNecessary();
+}
+
+bool Files::commitLog() {
+    if (!stagedLog_.commit()) {
+        return false;
+    }
+
+    return swapLogsIfNecessary();
+}
+
 phylum::SimpleFile &Files::data() {
     return data_;
 }
 
 FileNumber Files::logFileNumber() {
-    if (&log_.fd() == &file_logs_a_fd) {
-        return FileNumber::LogsA;
+    for (size_t i = 0; i < FileSystemNumberOfFiles; ++i) {
+        if (&log_.fd() == descriptors_[i]) {
+            return (FileNumber)i;
+        }
     }
-    return FileNumber::LogsB;
+    return FileNumber::None;
 }
 
 FileCopyOperation &Files::fileCopy() {
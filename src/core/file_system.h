@@ -6,19 +6,24 @@
 
 #include "data_logging.h"
 #include "data_replies.h"
+#include "file_cursor_table.h"
+#include "cached_storage.h"
 
 namespace fk {
 
 class FileSystem {
 private:
     phylum::Geometry g_{ 0, 4, 4, phylum::SectorSize };
-    phylum::ArduinoSdBackend storage_;
+    phylum::ArduinoSdBackend sd_;
+    CachedStorageBackend storage_{ sd_ };
     phylum::FileLayout<5> fs_{ storage_ };
 
 private:
     Files files_{ fs_ };
     DataLogging data_;
     DataReplies replies_;
+    FileCursorTable cursors_;
+    uint32_t erasing_{ 0 };
     bool formatted_{ false };
 
 public:
@@ -30,11 +35,63 @@ public:
     bool setup();
 
 public:
-    bool beginFileCopy(FileCopySettings settings);
-    bool flush();
-
+    /**
+     * Opens the file for Files::fileCopy, the pool is cleared and lends the
+     * copy its buffers, see FileCopyOperation::prepare.
+     */
+    bool beginFileCopy(FileCopySettings settings, Pool &pool);
+    bool flush(CommitPoint point = CommitPoint::Always);
+
+    /**
+     * Background work, commits appends that have been staged for longer
+     * than the commit interval and writes binary log entries out once
+     * there's a block's worth or they've waited long enough.
+     */
+    bool task();
+
+    /**
+     * Slower background work that's only done from Idle and Sleep, where
+     * nothing's waiting on us, erasing files and preparing the standby log
+     * as the active one fills.
+     */
+    bool idle();
+
+    /**
+     * Erases happen in the background, from idle, a file at a time. Until
+     * then the file reads as empty. Pending erases are saved with the
+     * cursors, so they're picked back up after a reset.
+     */
     bool erase(FileNumber number);
 
+    bool erasing(FileNumber number) const;
+
+    /**
+     * Size and version of the file. The file system is only asked the first
+     * time and again after the file's been erased, sizes of open files come
+     * from RAM.
+     */
+    CachedStat stat(FileNumber number);
+
+    /**
+     * Number of files waiting to be erased.
+     */
+    size_t erasing() const {
+        return __builtin_popcount(erasing_);
+    }
+
+    /**
+     * Logical offset of the beginning of the file, offsets the app and
+     * cursors see are this plus the position in the file.
+     */
+    uint32_t base(FileNumber number);
+
+    /**
+     * Once uploads have acknowledged everything in the data file and it's
+     * grown past DataSegmentSize it's dropped, with a single erase, and its
+     * base advanced past it. The file starts over as a new segment.
+     */
+    bool dropUploaded(FileNumber number);
+
     phylum::SimpleFile openSystem(phylum::OpenMode mode);
 
     phylum::FileLayout<5> &fs() {
@@ -49,6 +106,21 @@ public:
         return replies_;
     }
 
+    const BlockCacheStatistics &cacheStatistics() {
+        return storage_.cache().statistics();
+    }
+
+    FileCursorTable &cursors() {
+        return cursors_;
+    }
+
+    uint32_t blockSize() const;
+
+    /**
+     * Largest a file can grow to, in bytes.
+     */
+    uint32_t maximumSize(FileNumber number) const;
+
     Files &files() {
         return files_;
     }
@@ -56,6 +128,11 @@ public:
 private:
     bool closeSystemFiles();
     bool openSystemFiles();
+    FileCopySettings resolveTimeRange(FileCopySettings settings);
+    bool shouldCommit(CommitPoint point) const;
+    bool prepareStandbyLogIfNecessary();
+    bool eraseNext();
+    bool eraseNow(FileNumber number);
 
 };
 
@@ -6,9 +6,19 @@
 #include "tuning.h"
 #include "file_reader.h"
 #include "file_copy_operation.h"
+#include "staged_file.h"
+#include "binary_log.h"
 
 namespace fk {
 
+/**
+ * What QUERY_FILES needs to know about a file.
+ */
+struct CachedStat {
+    uint64_t size;
+    uint32_t version;
+};
+
 class Files {
 private:
     phylum::FileDescriptor file_system_area_fd = { "system",          100  };
@@ -23,13 +33,23 @@ private:
         &file_logs_b_fd,
         &file_data_fk
     };
+    phylum::FileDescriptor* logs_[FileSystemNumberOfLogs]{
+        &file_logs_a_fd,
+        &file_logs_b_fd
+    };
 
 private:
     phylum::SimpleFile opened_;
     phylum::SimpleFile log_;
+    phylum::SimpleFile standby_;
     phylum::SimpleFile data_;
     phylum::FileOpener *files_;
     FileCopyOperation fileCopy_;
+    StagedFile stagedData_{ data_ };
+    StagedFile stagedLog_{ log_ };
+    BinaryLog binaryLog_;
+    CachedStat stats_[FileSystemNumberOfFiles];
+    uint32_t statted_{ 0 };
     uint8_t errors_{ 0 };
 
 public:
@@ -53,6 +73,22 @@ public:
 public:
     bool swapLogsIfNecessary();
 
+    /**
+     * Erases and opens the log we'll rotate to next, so the swap itself is
+     * quick. Returns true if the standby is ready.
+     */
+    bool prepareStandbyLog();
+
+    bool hasStandbyLog();
+
+    /**
+     * Forgets what we know about the file, for when it's been erased or
+     * written to outside of the open files.
+     */
+    void invalidate(phylum::FileDescriptor &fd);
+
+    void invalidateAll();
+
     void error();
 
     void checkErrors();
@@ -63,6 +99,22 @@ public:
 
     phylum::SimpleFile &log();
 
+    StagedFile &stagedData();
+
+    StagedFile &stagedLog();
+
+    BinaryLog &binaryLog();
+
+    /**
+     * Writes any binary log entries to the log file.
+     */
+    bool commitBinaryLog();
+
+    /**
+     * Commits staged log appends, swapping logs if that filled this one.
+     */
+    bool commitLog();
+
     FileNumber logFileNumber();
 
     FileCopyOperation &fileCopy();
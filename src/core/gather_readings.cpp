@@ -19,16 +19,27 @@ void GatherReadings::enqueued() {
         return;
     }
 
+    schedule.clear();
+
+    for (auto m = state->attachedModules(); m != nullptr; m = m->np) {
+        if (m->type == fk_module_ModuleType_SENSOR) {
+            schedule.add(m->address);
+        }
+    }
+
     beginTakeReading.remaining(remaining);
 
+    state->getLatencies().beginGather();
+    startedTime = clock.getTime();
+
     state->takingReadings();
     leds->notifyReadingsBegin();
-    protocol.push(8, beginTakeReading);
     startedAt = 0;
+    active = 0;
 }
 
 TaskEval GatherReadings::task() {
-    if (!protocol.isBusy()) {
+    if (schedule.size() == 0) {
         return TaskEval::done();
     }
 
@@ -36,6 +47,33 @@ TaskEval GatherReadings::task() {
         startedAt = fk_uptime();
     }
 
+    if (!protocol.isBusy()) {
+        if (schedule.done()) {
+            auto &latencies = state->getLatencies();
+            log("Readings done after %lums (%lu polls, %lu wasted)", fk_uptime() - startedAt,
+                latencies.polls(), latencies.wasted());
+            if (schedule.allFailed()) {
+                return TaskEval::error();
+            }
+            return TaskEval::done();
+        }
+
+        auto next = schedule.next(fk_uptime());
+        if (next == nullptr) {
+            return TaskEval::idle();
+        }
+
+        active = next->address;
+
+        if (next->stage == GatherStage::Begin) {
+            protocol.push(active, beginTakeReading);
+        }
+        else {
+            queryReadingStatus.packed(!next->unpacked);
+            protocol.push(active, queryReadingStatus);
+        }
+    }
+
     auto finished = protocol.handle();
     if (finished) {
         if (finished.error()) {
@@ -50,30 +88,35 @@ TaskEval GatherReadings::task() {
 }
 
 TaskEval GatherReadings::done(ModuleProtocolHandler::Finished &finished) {
+    auto &latencies = state->getLatencies();
+
     if (finished.is(beginTakeReading)) {
-        auto delay = 300;
-        if (beginTakeReading.getBackoff() > 0) {
-            log("Using backoff of %lu", beginTakeReading.getBackoff());
-            delay = beginTakeReading.getBackoff();
-        }
-        protocol.push(8, queryReadingStatus, delay);
+        auto now = fk_uptime();
+        schedule.began(active, now, now);
+        schedule.poll(active, now + pollDelay(beginTakeReading.getBackoff()));
     }
     else if (finished.is(queryReadingStatus)) {
-        if (queryReadingStatus.isBegin() || queryReadingStatus.isBusy()) {
-            auto delay = 300;
-            if (queryReadingStatus.getBackoff() > 0) {
-                log("Using backoff of %lu", queryReadingStatus.getBackoff());
-                delay = queryReadingStatus.getBackoff();
-            }
-            protocol.push(8, queryReadingStatus, delay);
+        if (queryReadingStatus.isRejected()) {
+            log("[0x%x] Packed replies unsupported", active);
+            schedule.unpacked(active);
+            schedule.poll(active, fk_uptime());
+        }
+        else if (queryReadingStatus.isBegin() || queryReadingStatus.isBusy()) {
+            latencies.polled(true);
+            schedule.poll(active, fk_uptime() + pollDelay(queryReadingStatus.getBackoff()));
         }
         else if (queryReadingStatus.isDone()) {
-            state->merge(8, *finished.reply);
-            protocol.push(8, queryReadingStatus);
+            latencies.polled(false);
+            merge(*finished.reply);
+            while (protocol.additional(finished)) {
+                merge(*finished.reply);
+            }
+            schedule.poll(active, fk_uptime());
         }
         else {
-            log("Readings done after %lums", fk_uptime() - startedAt);
-            return TaskEval::done();
+            log("[0x%x] Readings done after %lums (predicted %lums)", active,
+                fk_uptime() - startedAt, latencies.predict(active));
+            schedule.finished(active);
         }
     }
 
@@ -83,18 +126,60 @@ TaskEval GatherReadings::done(ModuleProtocolHandler::Finished &finished) {
 }
 
 TaskEval GatherReadings::error(ModuleProtocolHandler::Finished &finished) {
-    if (finished.is(beginTakeReading)) {
-        return TaskEval::error();
-    } else if (finished.is(queryReadingStatus)) {
-        return TaskEval::error();
+    if (finished.is(beginTakeReading) || finished.is(queryReadingStatus)) {
+        // Give up on this module but keep gathering from the others.
+        log("[0x%x] Failed", active);
+        schedule.failed(active);
     }
     return TaskEval::idle();
 }
 
+uint32_t GatherReadings::pollDelay(uint32_t requested) {
+    // Once we know how long this module takes, check back when its readings
+    // should be done. Late readings fall back to the module's backoff.
+    auto predicted = state->getLatencies().predict(active);
+    auto module = schedule.get(active);
+    if (predicted > 0 && module != nullptr) {
+        auto elapsed = fk_uptime() - module->beganAt;
+        if (predicted > elapsed) {
+            return predicted - elapsed;
+        }
+    }
+    return backoff(requested);
+}
+
+void GatherReadings::merge(ModuleReplyMessage &reply) {
+    auto elapsed = reply.m().readingStatus.elapsed;
+    if (elapsed == 0) {
+        auto module = schedule.get(active);
+        if (module != nullptr) {
+            elapsed = fk_uptime() - module->beganAt;
+        }
+    }
+
+    // Readings a module buffered while sampling on its own were taken
+    // before this gather, how long ago says nothing about how long they
+    // take.
+    if (reply.m().sensorReading.time >= startedTime) {
+        state->getLatencies().observe(active, reply.m().sensorReading.sensor, elapsed);
+    }
+
+    state->merge(active, reply);
+}
+
+uint32_t GatherReadings::backoff(uint32_t requested) {
+    if (requested > 0) {
+        log("[0x%x] Using backoff of %lu", active, requested);
+        return requested;
+    }
+    return 300;
+}
+
 void GatherReadings::error() {
     if (peripherals.twoWire1().isOwner(this)) {
         peripherals.twoWire1().release(this);
     }
+    state->readingsDone();
     leds->notifyReadingsDone();
 }
 
@@ -102,6 +187,7 @@ void GatherReadings::done() {
     if (peripherals.twoWire1().isOwner(this)) {
         peripherals.twoWire1().release(this);
     }
+    state->readingsDone();
     leds->notifyReadingsDone();
 }
 
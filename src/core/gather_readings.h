@@ -5,6 +5,7 @@
 #include "core_state.h"
 #include "two_wire_task.h"
 #include "module_comms.h"
+#include "gather_schedule.h"
 
 namespace fk {
 
@@ -63,6 +64,8 @@ class QueryReadingStatus : public ModuleQuery {
 private:
     uint32_t backoff{ 0 };
     uint32_t status{ 0 };
+    bool packing{ true };
+    bool rejected{ false };
 
 public:
     const char *name() const override {
@@ -70,12 +73,33 @@ public:
     }
 
     void query(ModuleQueryMessage &message) override {
-        message.m().type = fk_module_QueryType_QUERY_READING_STATUS;
+        if (packing) {
+            message.m().type = (fk_module_QueryType)QueryReadingStatusPacked;
+        }
+        else {
+            message.m().type = fk_module_QueryType_QUERY_READING_STATUS;
+        }
     }
 
     void reply(ModuleReplyMessage &message) override {
         backoff = message.m().readingStatus.backoff;
         status = message.m().readingStatus.state;
+        rejected = packing && message.isError();
+    }
+
+    /**
+     * Whether to ask for packed replies, see QueryReadingStatusPacked.
+     */
+    void packed(bool value) {
+        packing = value;
+    }
+
+    /**
+     * True if the module didn't know the packed query, it should be asked
+     * again without.
+     */
+    bool isRejected() {
+        return rejected;
     }
 
     uint32_t getBackoff() {
@@ -108,8 +132,11 @@ private:
     BeginTakeReading beginTakeReading;
     QueryReadingStatus queryReadingStatus;
     ModuleProtocolHandler protocol;
+    GatherSchedule<MaximumNumberOfModules> schedule;
+    uint8_t active{ 0 };
     uint8_t retries{ 0 };
     uint32_t startedAt{ 0 };
+    uint32_t startedTime{ 0 };
 
 public:
     GatherReadings(uint32_t remaining, CoreState &state, Leds &leds, ModuleCommunications &communications);
@@ -122,6 +149,11 @@ public:
     void error() override;
     void done() override;
 
+private:
+    uint32_t backoff(uint32_t requested);
+    uint32_t pollDelay(uint32_t requested);
+    void merge(ModuleReplyMessage &reply);
+
 };
 
 }
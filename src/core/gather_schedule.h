@@ -0,0 +1,152 @@
+#ifndef FK_GATHER_SCHEDULE_H_INCLUDED
+#define FK_GATHER_SCHEDULE_H_INCLUDED
+
+#include <cinttypes>
+#include <cstdlib>
+
+namespace fk {
+
+enum class GatherStage {
+    Begin,
+    Poll,
+    Finished,
+    Failed,
+};
+
+struct ScheduledModule {
+    uint8_t address;
+    uint32_t pollAt;
+    GatherStage stage;
+    uint32_t beganAt;
+    bool unpacked;
+};
+
+/**
+ * Tracks where each module is in a gather and decides which one to talk to
+ * next. The bus only carries one transaction at a time, so rather than waiting
+ * out one module's backoff before starting the next we begin every module and
+ * then interleave status polls by when each module asked to be checked on.
+ */
+template<size_t N>
+class GatherSchedule {
+private:
+    ScheduledModule modules_[N];
+    size_t size_{ 0 };
+
+public:
+    void clear() {
+        size_ = 0;
+    }
+
+    bool add(uint8_t address) {
+        if (size_ == N) {
+            return false;
+        }
+        modules_[size_++] = ScheduledModule{ address, 0, GatherStage::Begin, 0, false };
+        return true;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    /**
+     * Returns the module that's been due the longest as of now, nullptr if
+     * none of them are due yet.
+     */
+    ScheduledModule *next(uint32_t now) {
+        ScheduledModule *selected = nullptr;
+        for (size_t i = 0; i < size_; ++i) {
+            auto &m = modules_[i];
+            if (m.stage == GatherStage::Finished || m.stage == GatherStage::Failed) {
+                continue;
+            }
+            if (m.pollAt > now) {
+                continue;
+            }
+            if (selected == nullptr || m.pollAt < selected->pollAt) {
+                selected = &m;
+            }
+        }
+        return selected;
+    }
+
+    ScheduledModule *get(uint8_t address) {
+        for (size_t i = 0; i < size_; ++i) {
+            if (modules_[i].address == address) {
+                return &modules_[i];
+            }
+        }
+        return nullptr;
+    }
+
+    void began(uint8_t address, uint32_t now, uint32_t at) {
+        auto m = get(address);
+        if (m != nullptr) {
+            m->stage = GatherStage::Poll;
+            m->beganAt = now;
+            m->pollAt = at;
+        }
+    }
+
+    void poll(uint8_t address, uint32_t at) {
+        auto m = get(address);
+        if (m != nullptr) {
+            m->stage = GatherStage::Poll;
+            m->pollAt = at;
+        }
+    }
+
+    /**
+     * The module only answers QUERY_READING_STATUS, one reading at a time.
+     */
+    void unpacked(uint8_t address) {
+        auto m = get(address);
+        if (m != nullptr) {
+            m->unpacked = true;
+        }
+    }
+
+    void finished(uint8_t address) {
+        auto m = get(address);
+        if (m != nullptr) {
+            m->stage = GatherStage::Finished;
+        }
+    }
+
+    void failed(uint8_t address) {
+        auto m = get(address);
+        if (m != nullptr) {
+            m->stage = GatherStage::Failed;
+        }
+    }
+
+    bool done() const {
+        return !anyPending();
+    }
+
+    bool allFailed() const {
+        for (size_t i = 0; i < size_; ++i) {
+            if (modules_[i].stage != GatherStage::Failed) {
+                return false;
+            }
+        }
+        return size_ > 0;
+    }
+
+private:
+    bool anyPending() const {
+        for (size_t i = 0; i < size_; ++i) {
+            auto &m = modules_[i];
+            if (m.stage == GatherStage::Begin || m.stage == GatherStage::Poll) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+};
+
+}
+
+#endif
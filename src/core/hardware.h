@@ -28,6 +28,11 @@ private:
     static uint32_t peripherals_on_at_;
 
 public:
+    /**
+     * Everything below this is in flash, SRAM begins here.
+     */
+    static constexpr uintptr_t FLASH_END = 0x20000000;
+
     static constexpr uint8_t WIFI_PIN_CS = 7;
     static constexpr uint8_t WIFI_PIN_IRQ = 16;
     static constexpr uint8_t WIFI_PIN_RST = 15;
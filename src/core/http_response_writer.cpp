@@ -25,6 +25,15 @@ void HttpHeadersWriter::writeHeaders(Url &url, const char *method, OutgoingHttpH
         stream_->println(headers.contentLength);
     }
 
+    if (headers.chunked) {
+        stream_->println("Transfer-Encoding: chunked");
+    }
+
+    if (headers.contentEncoding != nullptr) {
+        stream_->print("Content-Encoding: ");
+        stream_->println(headers.contentEncoding);
+    }
+
     if (headers.contentType != nullptr) {
         stream_->print("Content-Type: ");
         stream_->println(headers.contentType);
@@ -19,6 +19,8 @@ struct OutgoingHttpHeaders {
     uint32_t compiled;
     uint32_t contentLength{ InvalidContentLength };
     uint8_t fileId{ InvalidFileId };
+    const char *contentEncoding{ nullptr };
+    bool chunked{ false };
 
     OutgoingHttpHeaders(const char *contentType, uint32_t contentLength, const char *version,
                         const char *build, uint32_t compiled, const char *deviceId, uint8_t fileId) :
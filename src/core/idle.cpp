@@ -41,6 +41,7 @@ void Idle::status(DateTime now, lwcron::Scheduler::TaskAndTime nextTask) {
 
 void Idle::task() {
     services().alive();
+    services().fileSystem->idle();
 
     // NOTE: The assertions and the logging below are to find and fix
     // https://code.conservify.org/jira/browse/FK-434 and can be removed once
@@ -0,0 +1,126 @@
+#include "lzss.h"
+
+namespace fk {
+
+void LzssEncoder::begin(LzssOutput &output) {
+    output_ = &output;
+    memset(head_, 0, sizeof(head_));
+    groupSize_ = 0;
+    items_ = 0;
+    position_ = 0;
+    end_ = 0;
+    failed_ = false;
+    statistics_ = LzssStatistics{ 0, 0, 0, 0 };
+}
+
+bool LzssEncoder::write(const uint8_t *ptr, size_t size) {
+    statistics_.in += size;
+
+    while (size > 0 && !failed_) {
+        // Everything back to the furthest distance we'll reference stays.
+        auto space = position_ + LzssMaximumMatch - end_;
+        auto n = space < size ? space : size;
+        for (size_t i = 0; i < n; ++i) {
+            window_[(end_ + i) & (LzssWindowSize - 1)] = ptr[i];
+        }
+        end_ += n;
+        ptr += n;
+        size -= n;
+
+        encode(false);
+    }
+
+    return !failed_;
+}
+
+bool LzssEncoder::finish() {
+    encode(true);
+    flush();
+    return !failed_;
+}
+
+void LzssEncoder::encode(bool finishing) {
+    while (position_ < end_ && (finishing || end_ - position_ == LzssMaximumMatch)) {
+        auto available = end_ - position_;
+        auto length = (size_t)0;
+        auto distance = (size_t)0;
+
+        if (available >= LzssMinimumMatch) {
+            auto h = hash(position_);
+            distance = (uint16_t)(position_ - head_[h]);
+            head_[h] = (uint16_t)position_;
+
+            // Stale entries are harmless, anything within the window is real
+            // history and the bytes are compared anyway.
+            if (distance > 0 && distance <= LzssMaximumDistance && distance <= position_) {
+                auto limit = available < LzssMaximumMatch ? available : LzssMaximumMatch;
+                while (length < limit && at(position_ - distance + length) == at(position_ + length)) {
+                    length++;
+                }
+            }
+        }
+
+        if (length >= LzssMinimumMatch) {
+            match(distance, length);
+            for (size_t i = 1; i < length; ++i) {
+                insert(position_ + i);
+            }
+            position_ += length;
+        }
+        else {
+            literal(at(position_));
+            position_++;
+        }
+    }
+}
+
+void LzssEncoder::literal(uint8_t byte) {
+    if (items_ == 0) {
+        group_[0] = 0;
+        groupSize_ = 1;
+    }
+    group_[0] |= 1 << items_;
+    group_[groupSize_++] = byte;
+    statistics_.literals++;
+
+    if (++items_ == 8) {
+        flush();
+    }
+}
+
+void LzssEncoder::match(size_t distance, size_t length) {
+    if (items_ == 0) {
+        group_[0] = 0;
+        groupSize_ = 1;
+    }
+    auto token = (uint16_t)(((distance - 1) << 6) | (length - LzssMinimumMatch));
+    group_[groupSize_++] = (uint8_t)(token >> 8);
+    group_[groupSize_++] = (uint8_t)(token);
+    statistics_.matches++;
+
+    if (++items_ == 8) {
+        flush();
+    }
+}
+
+void LzssEncoder::flush() {
+    if (groupSize_ == 0) {
+        return;
+    }
+
+    if (!failed_ && !output_->write(group_, groupSize_)) {
+        failed_ = true;
+    }
+
+    statistics_.out += groupSize_;
+    groupSize_ = 0;
+    items_ = 0;
+}
+
+void LzssEncoder::insert(uint32_t position) {
+    if (position + LzssMinimumMatch <= end_) {
+        head_[hash(position)] = (uint16_t)position;
+    }
+}
+
+}
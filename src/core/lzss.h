@@ -0,0 +1,107 @@
+#ifndef FK_LZSS_H_INCLUDED
+#define FK_LZSS_H_INCLUDED
+
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
+namespace fk {
+
+/**
+ * Compressed streams are groups of up to eight items, each group preceded by
+ * a byte of flags, the lowest bit describing the first item. A set bit is a
+ * literal byte, a clear bit a two byte big endian back reference:
+ *
+ *   offset     10 bits, distance back into the output, less one
+ *   length     6 bits, bytes copied, less LzssMinimumMatch
+ *
+ * References may overlap the bytes they produce. The last group is cut short
+ * at the end of the stream, so decoders stop when they run out of input or
+ * have as many bytes as they were expecting.
+ */
+constexpr size_t LzssWindowSize = 1024;
+constexpr size_t LzssMinimumMatch = 3;
+constexpr size_t LzssMaximumMatch = LzssMinimumMatch + 63;
+constexpr size_t LzssMaximumDistance = LzssWindowSize - LzssMaximumMatch;
+constexpr size_t LzssHashSize = 256;
+constexpr size_t LzssMaximumGroup = 1 + 8 * 2;
+
+/**
+ * What uploads are marked with, for the Content-Encoding header.
+ */
+constexpr const char LzssContentEncoding[] = "x-fk-lzss";
+
+/**
+ * Where groups go as they're completed.
+ */
+class LzssOutput {
+public:
+    virtual bool write(const uint8_t *ptr, size_t size) = 0;
+
+};
+
+struct LzssStatistics {
+    uint32_t in;
+    uint32_t out;
+    uint32_t literals;
+    uint32_t matches;
+};
+
+/**
+ * Streaming LZSS that fits in a little over LzssWindowSize + LzssHashSize * 2
+ * bytes. The window is a ring holding what's been encoded and the bytes
+ * waiting to be. Only the most recent position for each hash of three bytes
+ * is remembered, so this finds fewer matches than a chained search but costs
+ * the same for every byte.
+ */
+class LzssEncoder {
+private:
+    LzssOutput *output_{ nullptr };
+    uint8_t window_[LzssWindowSize];
+    uint16_t head_[LzssHashSize];
+    uint8_t group_[LzssMaximumGroup];
+    size_t groupSize_{ 0 };
+    uint8_t items_{ 0 };
+    uint32_t position_{ 0 };
+    uint32_t end_{ 0 };
+    bool failed_{ false };
+    LzssStatistics statistics_{ 0, 0, 0, 0 };
+
+public:
+    void begin(LzssOutput &output);
+
+    /**
+     * Takes all of the bytes, encoding as the lookahead fills. Returns false
+     * if the output failed, now or earlier.
+     */
+    bool write(const uint8_t *ptr, size_t size);
+
+    /**
+     * Encodes what's left and writes the final group.
+     */
+    bool finish();
+
+    const LzssStatistics &statistics() const {
+        return statistics_;
+    }
+
+private:
+    void encode(bool finishing);
+    void literal(uint8_t byte);
+    void match(size_t distance, size_t length);
+    void flush();
+    void insert(uint32_t position);
+
+    uint8_t at(uint32_t position) const {
+        return window_[position & (LzssWindowSize - 1)];
+    }
+
+    uint8_t hash(uint32_t position) const {
+        return (uint8_t)((at(position) << 5) ^ (at(position + 1) << 2) ^ at(position + 2));
+    }
+
+};
+
+}
+
+#endif
@@ -36,6 +36,29 @@ ModuleReplyMessage &ModuleCommunications::dequeue() {
     return reply;
 }
 
+bool ModuleCommunications::dequeueAdditional() {
+    if (receivedPosition >= receivedSize) {
+        return false;
+    }
+
+    auto type = reply.m().type;
+    auto stream = pb_istream_from_buffer(received + receivedPosition, receivedSize - receivedPosition);
+    if (!pb_decode_delimited(&stream, fk_module_WireMessageReply_fields, reply.forDecode())) {
+        receivedPosition = receivedSize;
+        return false;
+    }
+
+    receivedPosition = receivedSize - stream.bytes_left;
+
+    // Anything else, including the empty terminating message, ends the run.
+    if (reply.m().type != type) {
+        receivedPosition = receivedSize;
+        return false;
+    }
+
+    return true;
+}
+
 TaskEval ModuleCommunications::task() {
     TwoWireStatistics tws;
     return task(tws);
@@ -79,13 +102,19 @@ TaskEval ModuleCommunications::task(TwoWireStatistics &tws) {
             }
 
             if (twoWireTask.received() > 0) {
-                auto protoReader = lws::ProtoBufMessageReader{ incoming.getReader() };
+                auto read = incoming.getReader().read(received, sizeof(received));
+                receivedSize = read > 0 ? (size_t)read : 0;
+                receivedPosition = 0;
 
-                if (!protoReader.read<SERIAL_BUFFER_SIZE>(fk_module_WireMessageReply_fields, reply.forDecode())) {
+                auto stream = pb_istream_from_buffer(received, receivedSize);
+                if (!pb_decode_delimited(&stream, fk_module_WireMessageReply_fields, reply.forDecode())) {
                     log("Error: Unable to read reply.");
+                    receivedSize = 0;
                     tws.malformed++;
                 }
                 else {
+                    receivedPosition = receivedSize - stream.bytes_left;
+
                     if (reply.m().type == fk_module_ReplyType_REPLY_BUSY || reply.m().type == fk_module_ReplyType_REPLY_RETRY) {
                         incoming.clear();
                         outgoing.clear();
@@ -174,4 +203,12 @@ ModuleProtocolHandler::Finished ModuleProtocolHandler::handle() {
     return Finished{ nullptr, nullptr };
 }
 
+bool ModuleProtocolHandler::additional(Finished &finished) {
+    if (finished.reply == nullptr) {
+        return false;
+    }
+
+    return communications->dequeueAdditional();
+}
+
 }
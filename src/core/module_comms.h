@@ -48,6 +48,9 @@ private:
     TwoWireTask twoWireTask;
     lws::CircularStreams<lws::RingBufferN<256>> outgoing;
     lws::CircularStreams<lws::RingBufferN<256>> incoming;
+    uint8_t received[SERIAL_BUFFER_SIZE];
+    size_t receivedSize{ 0 };
+    size_t receivedPosition{ 0 };
 
 public:
     ModuleCommunications(TwoWireBus &bus, Pool &pool);
@@ -63,6 +66,13 @@ public:
 
     ModuleReplyMessage &dequeue();
 
+    /**
+     * Modules may pack several replies of the same type into a single
+     * transaction. This decodes the next one into the reply that was last
+     * dequeued, returning false when there are no more.
+     */
+    bool dequeueAdditional();
+
     bool busy() {
         return address > 0;
     }
@@ -119,6 +129,8 @@ public:
 
     Finished handle();
 
+    bool additional(Finished &finished);
+
 };
 
 }
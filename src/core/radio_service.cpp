@@ -50,8 +50,8 @@ TaskEval RadioService::task() {
     return TaskEval::busy();
 }
 
-SendDataToLoraGateway::SendDataToLoraGateway(RadioService &radioService, FileSystem &fileSystem, FileCopySettings settings) :
-    Task("SendDataToLoraGateway"), radioService(&radioService), fileSystem(&fileSystem), settings(settings) {
+SendDataToLoraGateway::SendDataToLoraGateway(RadioService &radioService, FileSystem &fileSystem, FileCopySettings settings, Pool &pool) :
+    Task("SendDataToLoraGateway"), radioService(&radioService), fileSystem(&fileSystem), settings(settings), pool(&pool) {
 }
 
 void SendDataToLoraGateway::enqueued() {
@@ -68,7 +68,7 @@ TaskEval SendDataToLoraGateway::task() {
     if (!started) {
         started = true;
         copying = true;
-        if (!fileSystem->beginFileCopy(settings)) {
+        if (!fileSystem->beginFileCopy(settings, *pool)) {
             log("Failed to open file for reading.");
             return TaskEval::error();
         }
@@ -21,11 +21,12 @@ private:
     RadioService *radioService;
     FileSystem *fileSystem;
     FileCopySettings settings;
+    Pool *pool;
     bool started{ false };
     bool copying{ false };
 
 public:
-    SendDataToLoraGateway(RadioService &radioService, FileSystem &fileSystem, FileCopySettings settings);
+    SendDataToLoraGateway(RadioService &radioService, FileSystem &fileSystem, FileCopySettings settings, Pool &pool);
 
 public:
     void enqueued() override;
@@ -0,0 +1,261 @@
+#include <cmath>
+#include <cstring>
+
+#include "reading_block.h"
+
+namespace fk {
+
+class BlockWriter {
+private:
+    uint8_t *buffer_;
+    size_t size_;
+    size_t position_{ 0 };
+    bool overflowed_{ false };
+
+public:
+    BlockWriter(uint8_t *buffer, size_t size) : buffer_(buffer), size_(size) {
+    }
+
+public:
+    void byte(uint8_t value) {
+        if (position_ == size_) {
+            overflowed_ = true;
+            return;
+        }
+        buffer_[position_++] = value;
+    }
+
+    void varint(uint32_t value) {
+        while (value >= 0x80) {
+            byte((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        byte((uint8_t)value);
+    }
+
+    void zigzag(int32_t value) {
+        varint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+    }
+
+    void raw(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        for (auto i = 0; i < 4; ++i) {
+            byte((uint8_t)(bits >> (i * 8)));
+        }
+    }
+
+    size_t position() const {
+        return position_;
+    }
+
+    bool overflowed() const {
+        return overflowed_;
+    }
+
+};
+
+static size_t varint_size(uint32_t value) {
+    size_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+static float power_of_ten(uint8_t digits) {
+    float scale = 1.0f;
+    for (uint8_t i = 0; i < digits; ++i) {
+        scale *= 10.0f;
+    }
+    return scale;
+}
+
+ReadingBlockEncoder::ReadingBlockEncoder(uint8_t precision) : precision_(precision) {
+    if (precision_ > ReadingBlockMaximumPrecision) {
+        precision_ = ReadingBlockMaximumPrecision;
+    }
+}
+
+uint8_t ReadingBlockEncoder::precisionFor(float value) const {
+    if (!std::isfinite(value)) {
+        return ReadingBlockRawPrecision;
+    }
+
+    // Drop digits until the quantized value fits, large values just lose
+    // some of their fractional precision.
+    for (int32_t digits = precision_; digits >= 0; --digits) {
+        auto scaled = fabsf(value) * power_of_ten((uint8_t)digits);
+        if (scaled < 2147483520.0f) {
+            return (uint8_t)digits;
+        }
+    }
+
+    return ReadingBlockRawPrecision;
+}
+
+size_t ReadingBlockEncoder::encode(uint8_t *buffer, size_t size, uint32_t readingNumber, BlockReading *readings, size_t number) {
+    // Leave room for the record's own length, the field tag and the block's
+    // length and move the block down once we know how big they are.
+    constexpr size_t HeaderReserve = 12;
+
+    if (size <= HeaderReserve) {
+        return 0;
+    }
+
+    auto block = buffer + HeaderReserve;
+    auto blockSize = encodeBlock(block, size - HeaderReserve, readingNumber, readings, number);
+    if (blockSize == 0) {
+        return 0;
+    }
+
+    auto tag = (ReadingBlockField << 3) | 2;
+    auto bodySize = varint_size(tag) + varint_size(blockSize) + blockSize;
+
+    BlockWriter header{ buffer, HeaderReserve };
+    header.varint(bodySize);
+    header.varint(tag);
+    header.varint(blockSize);
+
+    memmove(buffer + header.position(), block, blockSize);
+
+    return header.position() + blockSize;
+}
+
+size_t ReadingBlockEncoder::encodeBlock(uint8_t *buffer, size_t size, uint32_t readingNumber, BlockReading *readings, size_t number) {
+    if (number == 0) {
+        return 0;
+    }
+
+    for (size_t i = 1; i < number; ++i) {
+        auto reading = readings[i];
+        auto j = i;
+        while (j > 0 && readings[j - 1].sensor > reading.sensor) {
+            readings[j] = readings[j - 1];
+            j--;
+        }
+        readings[j] = reading;
+    }
+
+    auto time = readings[0].time;
+    for (size_t i = 0; i < number; ++i) {
+        if (readings[i].sensor >= ReadingBlockMaximumSensors) {
+            return 0;
+        }
+        if (i > 0 && readings[i].sensor == readings[i - 1].sensor) {
+            return 0;
+        }
+        if (readings[i].time < time) {
+            time = readings[i].time;
+        }
+    }
+
+    uint8_t bitmap[ReadingBlockMaximumSensors / 8] = { 0 };
+    auto bitmapSize = (size_t)readings[number - 1].sensor / 8 + 1;
+    for (size_t i = 0; i < number; ++i) {
+        bitmap[readings[i].sensor / 8] |= 1 << (readings[i].sensor % 8);
+    }
+
+    BlockWriter writer{ buffer, size };
+
+    writer.byte(ReadingBlockVersion);
+    writer.varint(readingNumber);
+    writer.varint(time);
+    writer.varint(bitmapSize);
+    for (size_t i = 0; i < bitmapSize; ++i) {
+        writer.byte(bitmap[i]);
+    }
+
+    for (size_t i = 0; i < number; ++i) {
+        writer.byte(precisionFor(readings[i].value));
+    }
+
+    auto previous = time;
+    for (size_t i = 0; i < number; ++i) {
+        writer.zigzag((int32_t)(readings[i].time - previous));
+        previous = readings[i].time;
+    }
+
+    for (size_t i = 0; i < number; ++i) {
+        auto value = readings[i].value;
+        auto precision = precisionFor(value);
+        if (precision == ReadingBlockRawPrecision) {
+            writer.raw(value);
+        }
+        else {
+            writer.zigzag((int32_t)lroundf(value * power_of_ten(precision)));
+        }
+    }
+
+    if (writer.overflowed()) {
+        return 0;
+    }
+
+    return writer.position();
+}
+
+bool reading_block_decode(const uint8_t *data, size_t size, ReadingBlockVisitor &visitor) {
+    BlockReader reader{ data, size };
+
+    if (reader.byte() != ReadingBlockVersion) {
+        return false;
+    }
+
+    auto reading = (uint32_t)reader.varint();
+    auto time = (uint32_t)reader.varint();
+    auto bitmapSize = (size_t)reader.varint();
+    if (reader.failed() || bitmapSize > ReadingBlockMaximumSensors / 8) {
+        return false;
+    }
+
+    uint8_t sensors[ReadingBlockMaximumSensors];
+    size_t number = 0;
+    for (size_t i = 0; i < bitmapSize; ++i) {
+        auto bits = reader.byte();
+        for (auto b = 0; b < 8; ++b) {
+            if (bits & (1 << b)) {
+                sensors[number++] = (uint8_t)(i * 8 + b);
+            }
+        }
+    }
+
+    uint8_t precisions[ReadingBlockMaximumSensors];
+    for (size_t i = 0; i < number; ++i) {
+        precisions[i] = reader.byte();
+    }
+
+    uint32_t times[ReadingBlockMaximumSensors];
+    auto previous = time;
+    for (size_t i = 0; i < number; ++i) {
+        previous = previous + reader.zigzag();
+        times[i] = previous;
+    }
+
+    // Values are read before any are handed out so a truncated block is
+    // rejected as a whole.
+    float values[ReadingBlockMaximumSensors];
+    for (size_t i = 0; i < number; ++i) {
+        if (precisions[i] == ReadingBlockRawPrecision) {
+            values[i] = reader.raw();
+        }
+        else if (precisions[i] <= ReadingBlockMaximumPrecision) {
+            values[i] = (float)((double)reader.zigzag() / power_of_ten(precisions[i]));
+        }
+        else {
+            return false;
+        }
+    }
+
+    if (reader.failed()) {
+        return false;
+    }
+
+    for (size_t i = 0; i < number; ++i) {
+        visitor.reading(reading, sensors[i], times[i], values[i]);
+    }
+
+    return true;
+}
+
+}
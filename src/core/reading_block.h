@@ -0,0 +1,151 @@
+#ifndef FK_READING_BLOCK_H_INCLUDED
+#define FK_READING_BLOCK_H_INCLUDED
+
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
+namespace fk {
+
+struct BlockReading {
+    uint8_t sensor;
+    uint32_t time;
+    float value;
+};
+
+/**
+ * Compact, column oriented encoding of a set of readings, at most one per
+ * sensor. Blocks are written to the data file as a delimited DataRecord whose
+ * only field is ReadingBlockField, a field number the data protocol doesn't
+ * use, so existing readers skip them as unknown fields.
+ *
+ * Block layout:
+ *
+ *   version    u8, ReadingBlockVersion
+ *   reading    varint, reading number
+ *   time       varint, earliest reading time
+ *   sensors    varint length, then a bitmap with bit n set for sensor n
+ *   precision  u8 per sensor, decimal digits the value was quantized to or
+ *              ReadingBlockRawPrecision for a raw little endian float
+ *   times      zigzag varint per sensor, delta from the previous time
+ *   values     zigzag varint per sensor, round(value * 10^precision)
+ *
+ * Columns are in sensor order.
+ */
+constexpr uint32_t ReadingBlockField = 1000;
+constexpr uint8_t ReadingBlockVersion = 1;
+constexpr uint8_t ReadingBlockRawPrecision = 0xff;
+constexpr uint8_t ReadingBlockMaximumPrecision = 7;
+constexpr size_t ReadingBlockMaximumSensors = 64;
+
+/**
+ * Bounds checked reader over an encoded block or record, any read past the
+ * end marks the reader failed and returns zeros.
+ */
+class BlockReader {
+private:
+    const uint8_t *data_;
+    size_t size_;
+    size_t position_{ 0 };
+    bool failed_{ false };
+
+public:
+    BlockReader(const uint8_t *data, size_t size) : data_(data), size_(size) {
+    }
+
+public:
+    uint8_t byte() {
+        if (position_ == size_) {
+            failed_ = true;
+            return 0;
+        }
+        return data_[position_++];
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (auto shift = 0; shift < 64; shift += 7) {
+            auto b = byte();
+            value |= (uint64_t)(b & 0x7f) << shift;
+            if ((b & 0x80) == 0 || failed_) {
+                return value;
+            }
+        }
+        failed_ = true;
+        return 0;
+    }
+
+    int32_t zigzag() {
+        auto value = (uint32_t)varint();
+        return (int32_t)((value >> 1) ^ (~(value & 1) + 1));
+    }
+
+    float raw() {
+        uint32_t bits = 0;
+        for (auto i = 0; i < 4; ++i) {
+            bits |= (uint32_t)byte() << (i * 8);
+        }
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    bool skip(size_t bytes) {
+        if (size_ - position_ < bytes) {
+            failed_ = true;
+            return false;
+        }
+        position_ += bytes;
+        return true;
+    }
+
+    const uint8_t *ptr() const {
+        return data_ + position_;
+    }
+
+    size_t remaining() const {
+        return size_ - position_;
+    }
+
+    bool failed() const {
+        return failed_;
+    }
+
+};
+
+class ReadingBlockVisitor {
+public:
+    virtual void reading(uint32_t number, uint8_t sensor, uint32_t time, float value) = 0;
+};
+
+/**
+ * Decodes a block, without the surrounding record, passing each reading to
+ * the visitor. Returns false if the block was malformed, in which case the
+ * visitor sees none of its readings.
+ */
+bool reading_block_decode(const uint8_t *data, size_t size, ReadingBlockVisitor &visitor);
+
+class ReadingBlockEncoder {
+private:
+    uint8_t precision_;
+
+public:
+    ReadingBlockEncoder(uint8_t precision);
+
+public:
+    /**
+     * Encodes the readings as a complete data file record, sorting them by
+     * sensor in place. Returns the number of bytes written, zero if they
+     * didn't fit or a sensor appeared twice.
+     */
+    size_t encode(uint8_t *buffer, size_t size, uint32_t readingNumber, BlockReading *readings, size_t number);
+
+private:
+    size_t encodeBlock(uint8_t *buffer, size_t size, uint32_t readingNumber, BlockReading *readings, size_t number);
+    uint8_t precisionFor(float value) const;
+
+};
+
+}
+
+#endif
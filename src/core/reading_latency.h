@@ -0,0 +1,119 @@
+#ifndef FK_READING_LATENCY_H_INCLUDED
+#define FK_READING_LATENCY_H_INCLUDED
+
+#include <cinttypes>
+#include <cstdlib>
+
+namespace fk {
+
+struct SensorLatency {
+    uint8_t address;
+    uint8_t sensor;
+    uint32_t average;
+};
+
+/**
+ * Remembers how long each module's sensors take to have a reading ready, as
+ * reported by the module in readingStatus.elapsed, so that status polls can be
+ * scheduled for when the readings should be done rather than at a fixed
+ * interval. Entries are shared by all modules, N is the total number of
+ * sensors we'll track.
+ */
+template<size_t N>
+class ReadingLatencies {
+private:
+    SensorLatency entries_[N];
+    size_t size_{ 0 };
+    uint32_t polls_{ 0 };
+    uint32_t wasted_{ 0 };
+
+public:
+    void clear() {
+        size_ = 0;
+        polls_ = 0;
+        wasted_ = 0;
+    }
+
+    /**
+     * Starts counting polls afresh, latencies are kept.
+     */
+    void beginGather() {
+        polls_ = 0;
+        wasted_ = 0;
+    }
+
+    void observe(uint8_t address, uint8_t sensor, uint32_t elapsed) {
+        auto entry = find(address, sensor);
+        if (entry == nullptr) {
+            if (size_ == N) {
+                return;
+            }
+            entry = &entries_[size_++];
+            entry->address = address;
+            entry->sensor = sensor;
+            entry->average = elapsed;
+            return;
+        }
+
+        // Moving average, weighted towards history so one slow reading
+        // doesn't throw off the schedule.
+        entry->average = (entry->average * 3 + elapsed) / 4;
+    }
+
+    /**
+     * Predicted time after beginning that all of the module's readings will
+     * be ready, zero if we haven't seen that module yet.
+     */
+    uint32_t predict(uint8_t address) const {
+        uint32_t predicted = 0;
+        for (size_t i = 0; i < size_; ++i) {
+            if (entries_[i].address == address && entries_[i].average > predicted) {
+                predicted = entries_[i].average;
+            }
+        }
+        return predicted;
+    }
+
+    uint32_t predict(uint8_t address, uint8_t sensor) const {
+        for (size_t i = 0; i < size_; ++i) {
+            if (entries_[i].address == address && entries_[i].sensor == sensor) {
+                return entries_[i].average;
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * Records a status poll, wasted ones are those the module answered
+     * without any readings being ready. Counts are since beginGather.
+     */
+    void polled(bool wasted) {
+        polls_++;
+        if (wasted) {
+            wasted_++;
+        }
+    }
+
+    uint32_t polls() const {
+        return polls_;
+    }
+
+    uint32_t wasted() const {
+        return wasted_;
+    }
+
+private:
+    SensorLatency *find(uint8_t address, uint8_t sensor) {
+        for (size_t i = 0; i < size_; ++i) {
+            if (entries_[i].address == address && entries_[i].sensor == sensor) {
+                return &entries_[i];
+            }
+        }
+        return nullptr;
+    }
+
+};
+
+}
+
+#endif
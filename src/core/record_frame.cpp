@@ -0,0 +1,30 @@
+#include "record_frame.h"
+
+namespace fk {
+
+static void put32(uint8_t *ptr, uint32_t value) {
+    for (auto i = 0; i < 4; ++i) {
+        ptr[i] = (uint8_t)(value >> (i * 8));
+    }
+}
+
+void record_frame_sync(uint8_t *sync) {
+    auto tag = (RecordFrameField << 3) | 2;
+    sync[0] = RecordFrameHeaderSize - 1;
+    sync[1] = (uint8_t)(tag | 0x80);
+    sync[2] = (uint8_t)(tag >> 7);
+    sync[3] = RecordFrameHeaderSize - 4;
+    put32(sync + 4, RecordFrameMagic);
+}
+
+void record_frame_header(uint8_t *header, const uint8_t *record, size_t size) {
+    record_frame_sync(header);
+    put32(header + 8, size);
+    put32(header + 12, record_frame_crc(record, size));
+}
+
+uint32_t record_frame_crc(const uint8_t *record, size_t size) {
+    return ~crc32_update(~0, record, size);
+}
+
+}
@@ -0,0 +1,188 @@
+#ifndef FK_RECORD_FRAME_H_INCLUDED
+#define FK_RECORD_FRAME_H_INCLUDED
+
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
+#include "checksums.h"
+
+namespace fk {
+
+/**
+ * When framing is enabled every record appended to the data and log files is
+ * preceded by a frame, a delimited DataRecord whose only field is
+ * RecordFrameField, which readers that don't know about it skip. Frames are
+ * always RecordFrameHeaderSize bytes and begin with the same
+ * RecordFrameSyncSize bytes, so a reader that loses its place can scan for
+ * the next one.
+ *
+ *   length     0x0f, the delimiter
+ *   tag        0xd2 0x3e, RecordFrameField as length delimited
+ *   size       0x0c
+ *   magic      u32, RecordFrameMagic
+ *   record     u32, bytes framed, one or more whole delimited records
+ *   crc        u32, crc32 of those bytes
+ *
+ * All little endian.
+ */
+constexpr uint32_t RecordFrameField = 1002;
+constexpr uint32_t RecordFrameMagic = 0x31464b46;
+constexpr size_t RecordFrameHeaderSize = 16;
+constexpr size_t RecordFrameSyncSize = 8;
+
+/**
+ * Largest record a frame is believed to describe, anything bigger is taken
+ * to be a corrupted frame.
+ */
+constexpr size_t RecordFrameMaximumRecord = 4096;
+
+/**
+ * The bytes every frame begins with.
+ */
+void record_frame_sync(uint8_t *sync);
+
+void record_frame_header(uint8_t *header, const uint8_t *record, size_t size);
+
+uint32_t record_frame_crc(const uint8_t *record, size_t size);
+
+class RecordFrameVisitor {
+public:
+    virtual void record(const uint8_t *record, size_t size) = 0;
+
+};
+
+struct RecordFrameStatistics {
+    uint32_t good;
+    uint32_t bad;
+    uint32_t skipped;
+};
+
+/**
+ * Checks framed records as they stream past, handing good ones to the
+ * visitor. A frame that fails its check is skipped a byte at a time until
+ * the next sync, so one bad sector costs the records in it and not the rest
+ * of the file. Bytes outside of frames are counted as skipped.
+ *
+ * N bytes are buffered, enough for a frame and the largest record.
+ */
+template<size_t N = RecordFrameHeaderSize + RecordFrameMaximumRecord>
+class RecordFrameVerifier {
+private:
+    RecordFrameVisitor *visitor_;
+    uint8_t buffer_[N];
+    size_t size_{ 0 };
+    RecordFrameStatistics statistics_{ 0, 0, 0 };
+
+public:
+    RecordFrameVerifier(RecordFrameVisitor &visitor) : visitor_(&visitor) {
+    }
+
+public:
+    /**
+     * Takes the bytes, checking every frame they complete.
+     */
+    void write(const uint8_t *ptr, size_t size) {
+        while (size > 0) {
+            auto n = N - size_ < size ? N - size_ : size;
+            memcpy(buffer_ + size_, ptr, n);
+            size_ += n;
+            ptr += n;
+            size -= n;
+
+            process();
+        }
+    }
+
+    /**
+     * No more bytes are coming, whatever's left is an unfinished frame.
+     */
+    void finish() {
+        if (size_ > 0) {
+            if (sync(0, size_) == 0 && size_ >= RecordFrameSyncSize) {
+                statistics_.bad++;
+            }
+            statistics_.skipped += size_;
+            size_ = 0;
+        }
+    }
+
+    const RecordFrameStatistics &statistics() const {
+        return statistics_;
+    }
+
+private:
+    void process() {
+        while (true) {
+            auto found = sync(0, size_);
+            if (found > 0) {
+                statistics_.skipped += found;
+                drop(found);
+            }
+
+            if (size_ < RecordFrameHeaderSize) {
+                return;
+            }
+
+            auto record = get32(buffer_ + 8);
+            auto crc = get32(buffer_ + 12);
+            if (record == 0 || record > N - RecordFrameHeaderSize) {
+                statistics_.bad++;
+                statistics_.skipped++;
+                drop(1);
+                continue;
+            }
+
+            if (size_ < RecordFrameHeaderSize + record) {
+                return;
+            }
+
+            if (record_frame_crc(buffer_ + RecordFrameHeaderSize, record) != crc) {
+                statistics_.bad++;
+                statistics_.skipped++;
+                drop(1);
+                continue;
+            }
+
+            visitor_->record(buffer_ + RecordFrameHeaderSize, record);
+            statistics_.good++;
+            drop(RecordFrameHeaderSize + record);
+        }
+    }
+
+    /**
+     * Offset of the first sync at or after begin, or of a partial sync at
+     * the end of the buffer. The end if there's neither.
+     */
+    size_t sync(size_t begin, size_t end) const {
+        uint8_t expected[RecordFrameSyncSize];
+        record_frame_sync(expected);
+
+        for (auto i = begin; i < end; ++i) {
+            auto n = end - i < RecordFrameSyncSize ? end - i : RecordFrameSyncSize;
+            if (memcmp(buffer_ + i, expected, n) == 0) {
+                return i;
+            }
+        }
+
+        return end;
+    }
+
+    void drop(size_t n) {
+        memmove(buffer_, buffer_ + n, size_ - n);
+        size_ -= n;
+    }
+
+    static uint32_t get32(const uint8_t *ptr) {
+        uint32_t value = 0;
+        for (auto i = 0; i < 4; ++i) {
+            value |= (uint32_t)ptr[i] << (i * 8);
+        }
+        return value;
+    }
+
+};
+
+}
+
+#endif
@@ -21,7 +21,7 @@ void Sleep::sleep(uint32_t maximum) {
     auto stopping = started + (maximum * 1000);
     auto canSleep = false;
 
-    services().fileSystem->flush();
+    services().fileSystem->flush(CommitPoint::Sleep);
 
     while (fk_uptime() < stopping) {
         auto delayed = false;
@@ -45,6 +45,8 @@ void Sleep::sleep(uint32_t maximum) {
             delay(10);
         }
 
+        services().fileSystem->idle();
+
         if (!services().alive()) {
             canSleep = true;
         }
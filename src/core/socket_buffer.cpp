@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <cstring>
+
+#include "socket_buffer.h"
+
+namespace fk {
+
+/**
+ * Chunk sizes are always three hex digits, leading zeros are allowed and a
+ * buffer's never more than 0xfff.
+ */
+static constexpr size_t ChunkHeaderSize = 5;
+static constexpr size_t ChunkTrailerSize = 2;
+static constexpr size_t MaximumBufferSize = ChunkHeaderSize + 0xfff + ChunkTrailerSize;
+
+void SocketBuffer::begin(SocketOutput &output, uint8_t *buffer, size_t size) {
+    output_ = &output;
+    buffer_ = buffer;
+    size_ = std::min(size, MaximumBufferSize);
+    position_ = 0;
+    chunked_ = false;
+    statistics_ = SocketBufferStatistics{ 0, 0, 0 };
+}
+
+bool SocketBuffer::write(const uint8_t *ptr, size_t size) {
+    if (buffer_ == nullptr || !output_->connected()) {
+        return false;
+    }
+
+    while (size > 0) {
+        if (!chunked_ && position_ == 0 && size >= size_) {
+            if (!send(ptr, size_)) {
+                return false;
+            }
+            ptr += size_;
+            size -= size_;
+            continue;
+        }
+
+        auto n = std::min(capacity() - position_, size);
+        memcpy(buffer_ + position_, ptr, n);
+        position_ += n;
+        ptr += n;
+        size -= n;
+
+        if (position_ == capacity()) {
+            if (!flush()) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool SocketBuffer::flush() {
+    if (position_ == first()) {
+        return true;
+    }
+
+    auto size = position_;
+    position_ = first();
+
+    if (chunked_) {
+        const char *hex = "0123456789abcdef";
+        auto length = size - ChunkHeaderSize;
+        buffer_[0] = hex[(length >> 8) & 0xf];
+        buffer_[1] = hex[(length >> 4) & 0xf];
+        buffer_[2] = hex[length & 0xf];
+        buffer_[3] = '\r';
+        buffer_[4] = '\n';
+        buffer_[size++] = '\r';
+        buffer_[size++] = '\n';
+    }
+
+    return send(buffer_, size);
+}
+
+bool SocketBuffer::beginChunks() {
+    if (!flush()) {
+        return false;
+    }
+
+    chunked_ = true;
+    position_ = first();
+
+    return true;
+}
+
+bool SocketBuffer::finishChunks() {
+    if (!flush()) {
+        return false;
+    }
+
+    chunked_ = false;
+    position_ = 0;
+
+    const char *last = "0\r\n\r\n";
+    return send((const uint8_t *)last, strlen(last));
+}
+
+size_t SocketBuffer::first() const {
+    return chunked_ ? ChunkHeaderSize : 0;
+}
+
+size_t SocketBuffer::capacity() const {
+    return chunked_ ? size_ - ChunkTrailerSize : size_;
+}
+
+bool SocketBuffer::send(const uint8_t *ptr, size_t size) {
+    auto sent = output_->write(ptr, size);
+
+    statistics_.bytes += sent;
+    statistics_.segments++;
+    if (size < size_) {
+        statistics_.partial++;
+    }
+
+    return sent == size;
+}
+
+}
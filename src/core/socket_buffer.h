@@ -0,0 +1,86 @@
+#ifndef FK_SOCKET_BUFFER_H_INCLUDED
+#define FK_SOCKET_BUFFER_H_INCLUDED
+
+#include <cinttypes>
+#include <cstdlib>
+
+namespace fk {
+
+/**
+ * Where full buffers go, a connected socket.
+ */
+class SocketOutput {
+public:
+    virtual bool connected() = 0;
+    virtual size_t write(const uint8_t *ptr, size_t size) = 0;
+
+};
+
+struct SocketBufferStatistics {
+    uint32_t bytes;
+    uint32_t segments;
+    uint32_t partial;
+};
+
+/**
+ * Collects what's written into a buffer, ideally socket sized, and only sends
+ * whole buffers until it's flushed, so each send fills a SPI transaction with
+ * the WiFi module and a TCP segment. Writes of a buffer or more while nothing's
+ * waiting are sent straight from the caller's memory. The buffer is lent, as
+ * it's only needed for the length of a transfer.
+ *
+ * When chunking every buffer is sent as an HTTP chunk, the size and trailing
+ * CRLF are kept in the buffer so that's still one send.
+ */
+class SocketBuffer {
+private:
+    SocketOutput *output_{ nullptr };
+    uint8_t *buffer_{ nullptr };
+    size_t size_{ 0 };
+    size_t position_{ 0 };
+    bool chunked_{ false };
+    SocketBufferStatistics statistics_{ 0, 0, 0 };
+
+public:
+    /**
+     * Buffers larger than the largest chunk are only partly used.
+     */
+    void begin(SocketOutput &output, uint8_t *buffer, size_t size);
+
+    /**
+     * Takes all of the bytes or fails, after which the connection's unusable.
+     */
+    bool write(const uint8_t *ptr, size_t size);
+
+    /**
+     * Sends whatever's waiting, even if it's not a whole buffer.
+     */
+    bool flush();
+
+    /**
+     * Sends what's written from now on using chunked transfer coding, for
+     * bodies whose length isn't known when the headers are written.
+     */
+    bool beginChunks();
+
+    /**
+     * Sends the last chunk and the empty one that ends the body.
+     */
+    bool finishChunks();
+
+    const SocketBufferStatistics &statistics() const {
+        return statistics_;
+    }
+
+private:
+    bool send(const uint8_t *ptr, size_t size);
+
+    size_t first() const;
+
+    size_t capacity() const;
+
+};
+
+}
+
+#endif
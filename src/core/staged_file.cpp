@@ -0,0 +1,148 @@
+#include "staged_file.h"
+#include "configuration.h"
+#include "record_frame.h"
+#include "platform.h"
+
+namespace fk {
+
+StagedFile::StagedFile(phylum::SimpleFile &file) : file_(&file) {
+}
+
+bool StagedFile::write(uint8_t *ptr, size_t size) {
+    auto &storage = configuration.storage;
+
+    if (storage.commit_bytes == 0 || size > sizeof(buffer_)) {
+        if (!commit()) {
+            return false;
+        }
+        return writeThrough(ptr, size) == size;
+    }
+
+    if (size_ + size > sizeof(buffer_)) {
+        if (!commit()) {
+            return false;
+        }
+    }
+
+    memcpy(buffer_ + size_, ptr, size);
+
+    return staged(size);
+}
+
+bool StagedFile::append(uint8_t *ptr, size_t size) {
+    if (!configuration.storage.framed_records) {
+        return write(ptr, size);
+    }
+
+    if (size_ + RecordFrameHeaderSize + size > sizeof(buffer_)) {
+        if (!commit()) {
+            return false;
+        }
+    }
+
+    uint8_t header[RecordFrameHeaderSize];
+    record_frame_header(header, ptr, size);
+
+    if (!write(header, sizeof(header))) {
+        return false;
+    }
+
+    return write(ptr, size);
+}
+
+uint8_t *StagedFile::reserve(size_t size, size_t &available) {
+    auto frame = frameSize();
+
+    if (frame + size > sizeof(buffer_)) {
+        return nullptr;
+    }
+
+    if (size_ + frame + size > sizeof(buffer_)) {
+        if (!commit()) {
+            return nullptr;
+        }
+    }
+
+    available = sizeof(buffer_) - size_ - frame;
+
+    return buffer_ + size_ + frame;
+}
+
+bool StagedFile::appendReserved(size_t size) {
+    auto frame = frameSize();
+
+    if (size_ + frame + size > sizeof(buffer_)) {
+        return false;
+    }
+
+    if (frame > 0) {
+        record_frame_header(buffer_ + size_, buffer_ + size_ + frame, size);
+    }
+
+    return staged(frame + size);
+}
+
+bool StagedFile::commit() {
+    if (size_ == 0) {
+        return true;
+    }
+
+    auto written = writeThrough(buffer_, size_);
+    if (written < size_) {
+        memmove(buffer_, buffer_ + written, size_ - written);
+        size_ -= written;
+        return false;
+    }
+
+    size_ = 0;
+
+    return true;
+}
+
+bool StagedFile::due() const {
+    return size_ > 0 && fk_uptime() - stagedAt_ >= configuration.storage.commit_interval;
+}
+
+void StagedFile::discard() {
+    size_ = 0;
+}
+
+uint32_t StagedFile::tell() {
+    return (uint32_t)file_->tell() + size_;
+}
+
+size_t StagedFile::frameSize() const {
+    return configuration.storage.framed_records ? RecordFrameHeaderSize : 0;
+}
+
+bool StagedFile::staged(size_t size) {
+    auto &storage = configuration.storage;
+
+    if (size_ == 0) {
+        stagedAt_ = fk_uptime();
+    }
+
+    size_ += size;
+    statistics_.staged += size;
+
+    if (size_ >= storage.commit_bytes || fk_uptime() - stagedAt_ >= storage.commit_interval) {
+        return commit();
+    }
+
+    return true;
+}
+
+size_t StagedFile::writeThrough(uint8_t *ptr, size_t size) {
+    if (!*file_) {
+        return 0;
+    }
+
+    auto written = (size_t)file_->write(ptr, size, true);
+
+    statistics_.committed += written;
+    statistics_.commits++;
+
+    return written;
+}
+
+}
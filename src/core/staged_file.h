@@ -0,0 +1,111 @@
+#ifndef FK_STAGED_FILE_H_INCLUDED
+#define FK_STAGED_FILE_H_INCLUDED
+
+#include <phylum/phylum.h>
+
+#include "tuning.h"
+
+namespace fk {
+
+/**
+ * Points in the core's cycle where staged writes may be committed, which of
+ * them actually commit is configured in Configuration::Storage.
+ */
+enum class CommitPoint {
+    Always,
+    Readings,
+    Sleep,
+    Wifi,
+};
+
+struct StagingStatistics {
+    uint32_t staged;
+    uint32_t committed;
+    uint32_t commits;
+};
+
+/**
+ * Collects appends to a file in RAM and writes them in one go once enough
+ * has built up, enough time has passed or we reach a commit point, so the SD
+ * card sees a few large writes rather than one per record.
+ *
+ * This never logs, it sits under the log hook.
+ */
+class StagedFile {
+private:
+    phylum::SimpleFile *file_;
+    uint8_t buffer_[StagedFileBufferSize];
+    size_t size_{ 0 };
+    uint32_t stagedAt_{ 0 };
+    StagingStatistics statistics_{ 0, 0, 0 };
+
+public:
+    StagedFile(phylum::SimpleFile &file);
+
+public:
+    /**
+     * Stages the bytes, committing first if they won't fit and afterwards if
+     * a threshold was reached. Records are never split between commits.
+     */
+    bool write(uint8_t *ptr, size_t size);
+
+    /**
+     * Writes a whole record, after a frame if they're enabled, see
+     * record_frame.h. The frame and record are staged together.
+     */
+    bool append(uint8_t *ptr, size_t size);
+
+    /**
+     * Room at the end of the staged buffer for encoding records in place,
+     * committing first if there's less than size bytes free. Space for a
+     * frame is left ahead of it. available is set to all the room there is.
+     * Returns nullptr if size never fits or the commit failed.
+     */
+    uint8_t *reserve(size_t size, size_t &available);
+
+    /**
+     * Stages size bytes encoded where reserve pointed, framed together like
+     * one append.
+     */
+    bool appendReserved(size_t size);
+
+    /**
+     * Writes anything staged to the file. Whatever doesn't make it stays
+     * staged for the next commit.
+     */
+    bool commit();
+
+    /**
+     * True if appends have been staged for longer than the commit interval,
+     * for checking when nothing's being written.
+     */
+    bool due() const;
+
+    /**
+     * Drops anything staged, for when the file is closed or erased.
+     */
+    void discard();
+
+    /**
+     * Position the next append will be at, including staged bytes.
+     */
+    uint32_t tell();
+
+    size_t staged() const {
+        return size_;
+    }
+
+    const StagingStatistics &statistics() const {
+        return statistics_;
+    }
+
+private:
+    size_t frameSize() const;
+    bool staged(size_t size);
+    size_t writeThrough(uint8_t *ptr, size_t size);
+
+};
+
+}
+
+#endif
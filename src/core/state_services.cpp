@@ -10,6 +10,7 @@
 #include "user_button.h"
 #include "scheduler.h"
 #include "performance.h"
+#include "file_system.h"
 
 namespace fk {
 
@@ -25,6 +26,7 @@ bool MainServices::alive() {
     status->task();
     gps->read();
     button->task();
+    fileSystem->task();
     return leds->task();
 }
 
@@ -50,7 +50,7 @@ void TakeReadings::task() {
         remaining_--;
     }
 
-    services().fileSystem->flush();
+    services().fileSystem->flush(CommitPoint::Readings);
 
     resume();
 }
@@ -5,11 +5,12 @@
 #include "file_cursors.h"
 #include "http_response_writer.h"
 #include "device_id.h"
+#include "configuration.h"
 
 namespace fk {
 
-TransmitFileTask::TransmitFileTask(FileSystem &fileSystem, CoreState &state, Wifi &wifi, HttpTransmissionConfig &config, FileCopySettings settings) :
-    Task("TransmitFileTask"), fileSystem(&fileSystem), state(&state), wifi(&wifi), config(&config), settings(settings) {
+TransmitFileTask::TransmitFileTask(FileSystem &fileSystem, CoreState &state, Wifi &wifi, HttpTransmissionConfig &config, FileCopySettings settings, Pool &copying) :
+    Task("TransmitFileTask"), fileSystem(&fileSystem), state(&state), wifi(&wifi), config(&config), settings(settings), copying(&copying) {
 }
 
 void TransmitFileTask::enqueued() {
@@ -25,6 +26,12 @@ void TransmitFileTask::fileCopyTick() {
     }
 }
 
+bool TransmitFileTask::fileCopyBackPressure() {
+    // The server's answered early, likely with an error, see to it before
+    // sending any more.
+    return wcl.available() > 0;
+}
+
 TaskEval TransmitFileTask::task() {
     if (!connected) {
         if (!openFile()) {
@@ -39,14 +46,16 @@ TaskEval TransmitFileTask::task() {
     auto &fileCopy = fileSystem->files().fileCopy();
 
     if (!fileCopy.isFinished()) {
-        auto writer = WifiWriter{ wcl };
-        if (!fileCopy.copy(writer)) {
+        if (!fileCopy.copy(body(), this)) {
             return TaskEval::error();
         }
     }
 
     if (fileCopy.isFinished()) {
         if (copyFinishedAt == 0) {
+            if (!finish()) {
+                log("Error finishing");
+            }
             copyFinishedAt = fk_uptime();
         }
         if (fk_uptime() - copyFinishedAt > WifiTransmitBusyWaitMax) {
@@ -72,10 +81,18 @@ TaskEval TransmitFileTask::task() {
                 log("Success (status = %d) (%lums) (position = %d)", status, afterClosed, position);
             }
 
+            // Some of what was copied may still be in the compressor, and
+            // the server can't decode a stream that's been cut short.
             FileCursorManager fcm(*fileSystem);
-            if (!fcm.save(settings.file, position)) {
+            if (compressed && !fileCopy.isFinished()) {
+                log("Unfinished compressed upload, leaving cursor");
+            }
+            else if (!fcm.save(settings.file, fcm.base(settings.file) + position)) {
                 log("Failed to save cursor: %d", sizeof(FileCursors));
             }
+            else if (fileCopy.isFinished() && !fileSystem->dropUploaded(settings.file)) {
+                log("Failed to drop uploaded data");
+            }
         }
         else {
             tries++;
@@ -99,7 +116,7 @@ bool TransmitFileTask::openFile() {
     FileCursorManager fcm(*fileSystem);
     auto position = fcm.lookup(settings.file);
 
-    if (!fileSystem->beginFileCopy(FileCopySettings{ settings.file, (uint32_t)position, 0 })) {
+    if (!fileSystem->beginFileCopy(FileCopySettings{ settings.file, (uint32_t)position, 0 }, *copying)) {
         log("Error opening file");
         return false;
     }
@@ -159,7 +176,13 @@ bool TransmitFileTask::writeBeginning(Url &parsed) {
     auto fileSize = fileCopy.remaining();
     auto transmitting = fileSize + bufferSize;
 
-    HttpHeadersWriter httpWriter(&wcl);
+    compressed = configuration.wifi.compress_uploads;
+
+    // The pool was cleared when the file was opened for this try.
+    writer.begin(wcl, *copying);
+    compressor = nullptr;
+
+    HttpHeadersWriter httpWriter(&writer.print());
     OutgoingHttpHeaders headers{
         "application/vnd.fk.data+binary",
         transmitting,
@@ -169,13 +192,48 @@ bool TransmitFileTask::writeBeginning(Url &parsed) {
         deviceId.toString(),
         (uint8_t)settings.file
     };
+    if (compressed) {
+        headers.contentLength = OutgoingHttpHeaders::InvalidContentLength;
+        headers.contentEncoding = LzssContentEncoding;
+        headers.chunked = true;
+    }
     httpWriter.writeHeaders(parsed, "POST", headers);
 
+    if (compressed) {
+        writer.beginChunks();
+        compressor = copying->make<CompressingWriter>();
+        compressor->begin(writer);
+    }
+
     log("Sending %d + %d = %d bytes...", fileSize, bufferSize, transmitting);
     connected = true;
-    wcl.write(buffer, bufferSize);
+    body().write(buffer, bufferSize);
 
     return true;
 }
 
+lws::Writer &TransmitFileTask::body() {
+    if (compressed) {
+        return *compressor;
+    }
+    return writer;
+}
+
+bool TransmitFileTask::finish() {
+    auto success = true;
+
+    if (compressed) {
+        success = compressor->finish() && writer.finishChunks();
+        compressor->status();
+    }
+
+    if (!writer.flush()) {
+        success = false;
+    }
+
+    writer.status();
+
+    return success;
+}
+
 }
@@ -6,12 +6,21 @@
 #include "core_state.h"
 #include "file_reader.h"
 #include "wifi_tools.h"
+#include "wifi_client.h"
 #include "file_system.h"
 #include "url_parser.h"
 #include "http_response_parser.h"
+#include "compressing_writer.h"
 
 namespace fk {
 
+/**
+ * What a TransmitFileTask needs lent, the copy's buffers and the socket
+ * buffer, and space for compressing when uploads are compressed.
+ */
+constexpr size_t TransmitFilePoolSize = FileCopyPoolSize + alignedSize(WifiSocketBufferSize);
+constexpr size_t TransmitFileCompressingSize = alignedSize(sizeof(CompressingWriter));
+
 class TransmitFileTask : public Task, public FileCopyCallbacks {
 private:
     FileSystem *fileSystem;
@@ -19,25 +28,32 @@ private:
     Wifi *wifi;
     HttpTransmissionConfig *config;
     FileCopySettings settings;
+    Pool *copying;
     WiFiClient wcl;
+    BufferedWifiWriter writer;
+    CompressingWriter *compressor{ nullptr };
     HttpResponseParser parser;
     CachedDnsResolution cachedDns;
     uint32_t copyFinishedAt{ 0 };
     bool connected{ false };
+    bool compressed{ false };
     uint8_t tries{ 0 };
 
 public:
-    TransmitFileTask(FileSystem &fileSystem, CoreState &state, Wifi &wifi, HttpTransmissionConfig &config, FileCopySettings settings);
+    TransmitFileTask(FileSystem &fileSystem, CoreState &state, Wifi &wifi, HttpTransmissionConfig &config, FileCopySettings settings, Pool &copying);
 
 public:
     void enqueued();
     void fileCopyTick() override;
+    bool fileCopyBackPressure() override;
     TaskEval task() override;
 
 private:
     bool openFile();
     bool writeBeginning(Url &parsed);
     TaskEval openConnection();
+    lws::Writer &body();
+    bool finish();
 
 };
 
@@ -1,6 +1,7 @@
 #include "transmit_files.h"
 #include "transmit_file.h"
 #include "wifi_listening.h"
+#include "configuration.h"
 
 namespace fk {
 
@@ -22,12 +23,28 @@ public:
 
 public:
     void task() override {
+        // Each size gets its own frame, see WifiDownloadFile::task.
+        if (configuration.wifi.compress_uploads) {
+            transmit<TransmitFilePoolSize + TransmitFileCompressingSize>();
+        }
+        else {
+            transmit<TransmitFilePoolSize>();
+        }
+
+        back();
+    }
+
+private:
+    template<size_t N>
+    __attribute__((noinline)) void transmit() {
+        StaticPool<N> copying{ "FileCopy" };
         TransmitFileTask task{
             *services().fileSystem,
             *services().state,
             *services().wifi,
             *services().httpConfig,
-            settings_
+            settings_,
+            copying
         };
 
         // TODO: Maximum time in this state?
@@ -39,8 +56,6 @@ public:
                 break;
             }
         }
-
-        back();
     }
 };
 
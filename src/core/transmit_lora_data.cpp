@@ -19,7 +19,8 @@ void TransmitLoraData::task() {
         return;
     }
 
-    SendDataToLoraGateway sendDataToLoraGateway{ *services().radio, *services().fileSystem, { FileNumber::Data } };
+    StaticPool<FileCopyPoolSize> copying{ "FileCopy" };
+    SendDataToLoraGateway sendDataToLoraGateway{ *services().radio, *services().fileSystem, { FileNumber::Data }, copying };
 
     sendDataToLoraGateway.enqueued();
 
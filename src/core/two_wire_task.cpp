@@ -100,6 +100,8 @@ TaskEval TwoWireTask::send() {
     return TaskEval::idle();
 }
 
+static_assert(SERIAL_BUFFER_SIZE == TwoWireMessageBufferSize, "Two wire buffers and SERIAL_BUFFER_SIZE differ.");
+
 TaskEval TwoWireTask::receive() {
     if (repliesRemaining > 0) {
         uint8_t buffer[SERIAL_BUFFER_SIZE - 1];
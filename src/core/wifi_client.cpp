@@ -1,4 +1,5 @@
 #include "wifi_client.h"
+#include "platform.h"
 
 namespace fk {
 
@@ -22,5 +23,50 @@ int32_t WifiWriter::write(uint8_t byte) {
 void WifiWriter::close() {
 }
 
+void BufferedWifiWriter::begin(WiFiClient &wcl, Pool &pool) {
+    wcl_ = &wcl;
+    started_ = fk_uptime();
+    buffer_.begin(*this, (uint8_t *)pool.malloc(WifiSocketBufferSize), WifiSocketBufferSize);
 }
 
+int32_t BufferedWifiWriter::write(uint8_t *ptr, size_t size) {
+    if (!buffer_.write(ptr, size)) {
+        return Stream::EOS;
+    }
+    return size;
+}
+
+int32_t BufferedWifiWriter::write(uint8_t byte) {
+    return write(&byte, 1);
+}
+
+void BufferedWifiWriter::close() {
+    flush();
+}
+
+void BufferedWifiWriter::status() {
+    auto &s = buffer_.statistics();
+    auto elapsed = fk_uptime() - started_;
+    auto speed = elapsed > 0 ? s.bytes / ((float)elapsed / 1000.0f) : 0.0f;
+    logtracef("Wifi", "%lu bytes in %lu sends (%lu partial) %lums %.2fbps",
+              s.bytes, s.segments, s.partial, elapsed, speed);
+}
+
+bool BufferedWifiWriter::connected() {
+    return wcl_ != nullptr && wcl_->connected();
+}
+
+size_t BufferedWifiWriter::write(const uint8_t *ptr, size_t size) {
+    return wcl_->write(ptr, size);
+}
+
+size_t BufferedWifiWriter::Printer::write(uint8_t byte) {
+    return write(&byte, 1);
+}
+
+size_t BufferedWifiWriter::Printer::write(const uint8_t *buffer, size_t size) {
+    auto written = writer_->write(const_cast<uint8_t *>(buffer), size);
+    return written > 0 ? written : 0;
+}
+
+}
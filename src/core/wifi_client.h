@@ -7,6 +7,9 @@
 #include <WiFiServer.h>
 
 #include "wifi_message_buffer.h"
+#include "socket_buffer.h"
+#include "pool.h"
+#include "tuning.h"
 
 namespace fk {
 
@@ -60,6 +63,83 @@ public:
 
 };
 
+/**
+ * Writes to a WiFiClient through a SocketBuffer, see socket_buffer.h.
+ *
+ * This outlives a single write, it's kept for the whole transfer, and the
+ * buffer's borrowed from the pool that's lent for it.
+ */
+class BufferedWifiWriter : public lws::Writer, SocketOutput {
+private:
+    class Printer : public Print {
+    private:
+        BufferedWifiWriter *writer_;
+
+    public:
+        Printer(BufferedWifiWriter &writer) : writer_(&writer) {
+        }
+
+    public:
+        size_t write(uint8_t byte) override;
+        size_t write(const uint8_t *buffer, size_t size) override;
+
+    };
+
+private:
+    WiFiClient *wcl_{ nullptr };
+    Printer printer_{ *this };
+    SocketBuffer buffer_;
+    uint32_t started_{ 0 };
+
+public:
+    /**
+     * Takes WifiSocketBufferSize bytes from the pool.
+     */
+    void begin(WiFiClient &wcl, Pool &pool);
+
+    int32_t write(uint8_t *ptr, size_t size) override;
+    int32_t write(uint8_t byte) override;
+
+    /**
+     * Flushes, the connection is left open.
+     */
+    void close() override;
+
+    bool flush() {
+        return buffer_.flush();
+    }
+
+    bool beginChunks() {
+        return buffer_.beginChunks();
+    }
+
+    bool finishChunks() {
+        return buffer_.finishChunks();
+    }
+
+    /**
+     * For writing through Arduino's Print, as the HTTP headers are.
+     */
+    Print &print() {
+        return printer_;
+    }
+
+    const SocketBufferStatistics &statistics() const {
+        return buffer_.statistics();
+    }
+
+    /**
+     * Logs bytes sent, how many sends that took and the throughput since
+     * begin.
+     */
+    void status();
+
+private:
+    bool connected() override;
+    size_t write(const uint8_t *ptr, size_t size) override;
+
+};
+
 class WifiConnection {
 private:
     WiFiClient wcl;
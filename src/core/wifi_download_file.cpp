@@ -6,7 +6,32 @@
 namespace fk {
 
 void WifiDownloadFile::task() {
+    // Each size gets its own frame, so downloads only take the stack they
+    // need rather than the most any download could.
+    auto compressed = settings_.isCompressed();
+    auto summary = settings_.isSummary();
+    if (compressed && summary) {
+        download<DownloadFilePoolSize + DownloadFileCompressingSize + DownloadFileSummarizingSize>();
+    }
+    else if (compressed) {
+        download<DownloadFilePoolSize + DownloadFileCompressingSize>();
+    }
+    else if (summary) {
+        download<DownloadFilePoolSize + DownloadFileSummarizingSize>();
+    }
+    else {
+        download<DownloadFilePoolSize>();
+    }
+
+    services().appServicer->flushAndClose();
+
+    transit<WifiConnectionCompleted>();
+}
+
+template<size_t N>
+void WifiDownloadFile::download() {
     StaticPool<384> pool{"WifiDownloadFile"};
+    StaticPool<N> copying{ "FileCopy" };
     AppReplyMessage reply(&pool);
 
     DownloadFileTask task{
@@ -15,7 +40,8 @@ void WifiDownloadFile::task() {
         reply,
         connection_->getBuffer(),
         *connection_,
-        settings_
+        settings_,
+        copying
     };
 
     task.enqueued();
@@ -24,10 +50,6 @@ void WifiDownloadFile::task() {
         services().leds->task();
         services().watchdog->task();
     }
-
-    services().appServicer->flushAndClose();
-
-    transit<WifiConnectionCompleted>();
 }
 
 }
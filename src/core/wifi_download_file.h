@@ -25,6 +25,11 @@ public:
 
 public:
     void task() override;
+
+private:
+    template<size_t N>
+    void download() __attribute__((noinline));
+
 };
 
 }
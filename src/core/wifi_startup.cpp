@@ -4,6 +4,7 @@
 #include "wifi_disable.h"
 #include "transmit_files.h"
 #include "wifi.h"
+#include "file_system.h"
 
 namespace fk {
 
@@ -20,6 +21,9 @@ void WifiStartup::task() {
     // Reset this because some transitions are unable to use transit_into.
     config_ = { };
 
+    // Anything staged should be in the files before they can be downloaded.
+    services().fileSystem->flush(CommitPoint::Wifi);
+
     if (services().wifi->disabled()) {
         if (!services().wifi->begin()) {
             transit_into<WifiDisable>();
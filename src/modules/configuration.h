@@ -6,7 +6,41 @@
 namespace fk {
 
 struct Configuration {
+    struct Sampling {
+        /**
+         * Sample on our own this often, in milliseconds, keeping readings
+         * for the core to drain when it next asks, see PendingReadings. Zero
+         * to only take readings when the core asks.
+         */
+        #if defined(FK_MODULE_SAMPLE_INTERVAL)
+        uint32_t interval{ FK_MODULE_SAMPLE_INTERVAL };
+        #else
+        uint32_t interval{ 0 };
+        #endif
+
+        /**
+         * Raw samples averaged into each reported reading, see
+         * PendingReadings::aggregate.
+         */
+        #if defined(FK_MODULE_OVERSAMPLE)
+        uint32_t samples{ FK_MODULE_OVERSAMPLE };
+        #else
+        uint32_t samples{ 1 };
+        #endif
+
+        /**
+         * Readings that moved less than this since the last reported one
+         * aren't reported, zero reports every reading.
+         */
+        #if defined(FK_MODULE_DEADBAND)
+        float deadband{ FK_MODULE_DEADBAND };
+        #else
+        float deadband{ 0.0f };
+        #endif
+    };
+
     CommonConfiguration common;
+    Sampling sampling;
 };
 
 extern const Configuration configuration;
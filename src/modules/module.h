@@ -13,6 +13,7 @@
 #include "two_wire_child.h"
 #include "pending_readings.h"
 #include "hardware.h"
+#include "configuration.h"
 
 namespace fk {
 
@@ -56,6 +57,9 @@ public:
     virtual void begin() {
         moduleServices_.hooks = hooks();
 
+        readings_.sampleEvery(configuration.sampling.interval);
+        readings_.aggregate(configuration.sampling.samples, configuration.sampling.deadband);
+
         ModuleServicesState::services(moduleServices_);
 
         fsm_list::start();
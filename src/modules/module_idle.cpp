@@ -6,6 +6,8 @@
 #include "module_servicer.h"
 #include "message_buffer.h"
 #include "two_wire_child.h"
+#include "pending_readings.h"
+#include "module_callbacks.h"
 
 namespace fk {
 
@@ -18,11 +20,18 @@ void ModuleIdle::entry() {
 void ModuleIdle::task() {
     if (!services().child->incoming().empty()) {
         transit<ModuleServicer>();
+        return;
     }
     else {
         services().alive();
     }
 
+    if (services().readings->needsSamples() || services().readings->beginSample()) {
+        trace("Sampling (%d buffered)", services().readings->buffered());
+        transit(services().callbacks->states().readings);
+        return;
+    }
+
     if (elapsed() > ModuleIdleRebootInterval) {
         log("Reboot due to inactivity.");
         NVIC_SystemReset();
@@ -5,9 +5,16 @@
 #include "module_receive_data.h"
 #include "firmware_storage.h"
 #include "module_firmware_self_flash.h"
+#include "pending_readings.h"
+#include "tuning.h"
 
 namespace fk {
 
+/**
+ * Space left at the end of a packed reading status reply for the terminator.
+ */
+constexpr size_t ReadingStatusTerminatorReserve = 4;
+
 void ModuleServicer::task() {
     auto& incoming = services().child->incoming();
     auto& outgoing = services().child->outgoing();
@@ -45,6 +52,11 @@ void ModuleServicer::handle(ModuleQueryMessage &query) {
 
     services().child->clear();
 
+    auto packing = (uint32_t)query.m().type == QueryReadingStatusPacked;
+    if (packing) {
+        query.m().type = fk_module_QueryType_QUERY_READING_STATUS;
+    }
+
     switch (query.m().type) {
     case fk_module_QueryType_QUERY_CAPABILITIES: {
         log("Module info (%lu)", query.m().beginTakeReadings.callerTime);
@@ -100,6 +112,15 @@ void ModuleServicer::handle(ModuleQueryMessage &query) {
         reply.m().readingStatus.state = fk_module_ReadingState_BEGIN;
         reply.m().readingStatus.backoff = 1000;
 
+        // When we're sampling on our own and have readings waiting there's
+        // no need to take another, the core can start draining right away.
+        if (services().readings->sampling() && services().readings->buffered() > 0) {
+            log("Have %d buffered readings (%lu dropped)", services().readings->buffered(), services().readings->dropped());
+            reply.m().readingStatus.backoff = 1;
+            outgoing.write(reply);
+            break;
+        }
+
         for (size_t i = 0; i < info->numberOfSensors; ++i) {
             info->readings[i].status = SensorReadingStatus::Busy;
         }
@@ -117,32 +138,70 @@ void ModuleServicer::handle(ModuleQueryMessage &query) {
         break;
     }
     case fk_module_QueryType_QUERY_READING_STATUS: {
-        log("Reading status (%lu)", query.m().queryReadingStatus.sleep);
+        log("Reading status (%lu)%s", query.m().queryReadingStatus.sleep, packing ? " packed" : "");
 
         ModuleReplyMessage reply(*pool);
         reply.m().type = fk_module_ReplyType_REPLY_READING_STATUS;
         reply.m().readingStatus.state = fk_module_ReadingState_IDLE;
         reply.m().readingStatus.backoff = 1000;
 
+        // Every finished reading that fits is packed into this reply, one
+        // message after another. Those that don't fit stay Done and go out
+        // the next time we're asked, so the core keeps polling until IDLE.
+        // Cores that don't ask with QueryReadingStatusPacked get one.
+        auto packed = 0;
+        auto readings = services().readings;
+        while (readings->buffered() > 0 && (packing || packed == 0)) {
+            auto &buffered = readings->oldest();
+            reply.m().readingStatus.state = fk_module_ReadingState_DONE;
+            reply.m().readingStatus.elapsed = readings->elapsed(buffered.sensor);
+            reply.m().sensorReading.sensor = buffered.sensor;
+            reply.m().sensorReading.time = buffered.time;
+            reply.m().sensorReading.value = buffered.value;
+            if (!outgoing.append(reply, TwoWireMaximumReplySize - ReadingStatusTerminatorReserve)) {
+                break;
+            }
+            readings->pop();
+            packed++;
+        }
+
         for (size_t i = 0; i < info->numberOfSensors; ++i) {
             if (info->readings[i].status == SensorReadingStatus::Busy) {
-                if (reply.m().readingStatus.state == fk_module_ReadingState_BUSY) {
+                if (reply.m().readingStatus.state == fk_module_ReadingState_IDLE) {
                     reply.m().readingStatus.state = fk_module_ReadingState_BUSY;
                 }
             }
-            if (info->readings[i].status == SensorReadingStatus::Done) {
-                trace("Sending reading %d", i);
+            if (info->readings[i].status == SensorReadingStatus::Done && readings->buffered() == 0 && (packing || packed == 0)) {
                 reply.m().readingStatus.state = fk_module_ReadingState_DONE;
-                reply.m().readingStatus.elapsed = pending.elapsed;
+                reply.m().readingStatus.elapsed = services().readings->elapsed(i);
                 reply.m().sensorReading.sensor = i;
                 reply.m().sensorReading.time = info->readings[i].time;
                 reply.m().sensorReading.value = info->readings[i].value;
+                if (!outgoing.append(reply, TwoWireMaximumReplySize - ReadingStatusTerminatorReserve)) {
+                    break;
+                }
+                auto &statistics = services().readings->statistics(i);
+                if (statistics.count() > 1) {
+                    trace("Sending reading %d (n=%lu min=%f max=%f sd=%f)", i, statistics.count(),
+                          statistics.min(), statistics.max(), statistics.stddev());
+                }
+                else {
+                    trace("Sending reading %d", i);
+                }
                 info->readings[i].status = SensorReadingStatus::Idle;
-                break;
+                packed++;
             }
         }
 
-        outgoing.write(reply);
+        if (packed == 0) {
+            outgoing.write(reply);
+        }
+        else if (packing) {
+            // An empty message marks the end of the packed replies.
+            ModuleReplyMessage terminator(*pool);
+            outgoing.append(terminator, TwoWireMaximumReplySize);
+            log("Sending %d readings (%d bytes)", packed, outgoing.position());
+        }
 
         break;
     }
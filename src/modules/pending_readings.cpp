@@ -1,5 +1,6 @@
 #include "pending_readings.h"
 #include "rtc.h"
+#include "platform.h"
 
 namespace fk {
 
@@ -9,6 +10,53 @@ PendingReadings::PendingReadings(ModuleInfo &info) : info_(&info) {
 void PendingReadings::done(size_t i, float value) {
     assert(i < info_->numberOfSensors);
 
+    elapsed_[i] = fk_uptime() - began_;
+
+    if (samples_ > 1 || deadband_ > 0.0f) {
+        auto &statistics = statistics_[i];
+        if (statistics.count() >= samples_) {
+            statistics.clear();
+        }
+
+        statistics.add(value);
+
+        if (statistics.count() < samples_) {
+            return;
+        }
+
+        value = statistics.mean();
+
+        auto mask = (uint32_t)1 << i;
+        if (deadband_ > 0.0f && (hasReported_ & mask) && fabsf(value - reported_[i]) < deadband_) {
+            info_->readings[i].status = SensorReadingStatus::Idle;
+            suppressed_++;
+            return;
+        }
+
+        reported_[i] = value;
+        hasReported_ |= mask;
+    }
+
+    publish(i, value);
+}
+
+void PendingReadings::publish(size_t i, float value) {
+    if (sampling()) {
+        if (buffered_ == ModuleReadingsBufferSize) {
+            pop();
+            dropped_++;
+        }
+
+        auto tail = (head_ + buffered_) % ModuleReadingsBufferSize;
+        buffer_[tail] = IncomingSensorReading{ (uint8_t)i, clock.getTime(), value };
+        buffered_++;
+
+        // The reading's waiting in the ring, a core that began readings
+        // shouldn't be told this sensor's still busy.
+        info_->readings[i].status = SensorReadingStatus::Idle;
+        return;
+    }
+
     info_->readings[i].time = clock.getTime();
     info_->readings[i].value = value;
     info_->readings[i].status = SensorReadingStatus::Done;
@@ -16,10 +64,78 @@ void PendingReadings::done(size_t i, float value) {
 
 void PendingReadings::begin(size_t remaining) {
     remaining_ = remaining;
+    began_ = fk_uptime();
+    for (auto &e : elapsed_) {
+        e = 0;
+    }
+}
+
+uint32_t PendingReadings::elapsed(size_t i) const {
+    assert(i < info_->numberOfSensors);
+
+    return elapsed_[i];
 }
 
 size_t PendingReadings::remaining() const {
     return remaining_;
 }
 
+void PendingReadings::sampleEvery(uint32_t interval) {
+    interval_ = interval;
+    sampledAt_ = 0;
+}
+
+bool PendingReadings::beginSample() {
+    if (!sampling()) {
+        return false;
+    }
+
+    if (sampledAt_ > 0 && fk_uptime() - sampledAt_ < interval_) {
+        return false;
+    }
+
+    sampledAt_ = fk_uptime();
+    begin(1);
+
+    return true;
+}
+
+void PendingReadings::aggregate(uint32_t samples, float deadband) {
+    samples_ = samples > 0 ? samples : 1;
+    deadband_ = deadband;
+    hasReported_ = 0;
+    for (auto &s : statistics_) {
+        s.clear();
+    }
+}
+
+bool PendingReadings::needsSamples() const {
+    for (size_t i = 0; i < info_->numberOfSensors; ++i) {
+        auto count = statistics_[i].count();
+        if (count > 0 && count < samples_) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const RunningStatistics &PendingReadings::statistics(size_t i) const {
+    assert(i < info_->numberOfSensors);
+
+    return statistics_[i];
+}
+
+IncomingSensorReading &PendingReadings::oldest() {
+    assert(buffered_ > 0);
+
+    return buffer_[head_];
+}
+
+void PendingReadings::pop() {
+    assert(buffered_ > 0);
+
+    head_ = (head_ + 1) % ModuleReadingsBufferSize;
+    buffered_--;
+}
+
 }
@@ -2,6 +2,8 @@
 #define FK_PENDING_READINGS_H_INCLUDED
 
 #include "module_info.h"
+#include "tuning.h"
+#include "running_statistics.h"
 
 namespace fk {
 
@@ -9,6 +11,20 @@ class PendingReadings {
 private:
     ModuleInfo *info_;
     size_t remaining_{ 0 };
+    uint32_t began_{ 0 };
+    uint32_t elapsed_[MaximumNumberOfSensors];
+    uint32_t interval_{ 0 };
+    uint32_t sampledAt_{ 0 };
+    IncomingSensorReading buffer_[ModuleReadingsBufferSize];
+    size_t head_{ 0 };
+    size_t buffered_{ 0 };
+    uint32_t dropped_{ 0 };
+    uint32_t samples_{ 1 };
+    float deadband_{ 0.0f };
+    RunningStatistics statistics_[MaximumNumberOfSensors];
+    float reported_[MaximumNumberOfSensors];
+    uint32_t hasReported_{ 0 };
+    uint32_t suppressed_{ 0 };
 
 public:
     PendingReadings(ModuleInfo &info);
@@ -20,6 +36,69 @@ public:
 
     size_t remaining() const;
 
+    /**
+     * How long after begin the given sensor's latest reading was done.
+     */
+    uint32_t elapsed(size_t i) const;
+
+public:
+    /**
+     * Sample on our own every interval milliseconds, zero to only sample
+     * when the core asks. While sampling, readings are kept in a ring buffer
+     * that the core drains when it next asks for reading status.
+     */
+    void sampleEvery(uint32_t interval);
+
+    bool sampling() const {
+        return interval_ > 0;
+    }
+
+    /**
+     * True, and begins a sample, if it's time for one.
+     */
+    bool beginSample();
+
+    size_t buffered() const {
+        return buffered_;
+    }
+
+    uint32_t dropped() const {
+        return dropped_;
+    }
+
+    IncomingSensorReading &oldest();
+
+    void pop();
+
+public:
+    /**
+     * Report the mean of every samples raw readings instead of each one. With
+     * a deadband, sensors whose mean moved less than that since the last
+     * reported value aren't reported at all.
+     *
+     * The module protocol carries one value per reading so only the mean
+     * reaches the core, minimum, maximum and deviation stay here for the
+     * module's own logs.
+     */
+    void aggregate(uint32_t samples, float deadband = 0.0f);
+
+    /**
+     * True while any sensor is partway through collecting its samples.
+     */
+    bool needsSamples() const;
+
+    /**
+     * Statistics for the sensor's latest, or in progress, aggregate.
+     */
+    const RunningStatistics &statistics(size_t i) const;
+
+    uint32_t suppressed() const {
+        return suppressed_;
+    }
+
+private:
+    void publish(size_t i, float value);
+
 };
 
 }
@@ -0,0 +1,85 @@
+#ifndef FK_RUNNING_STATISTICS_H_INCLUDED
+#define FK_RUNNING_STATISTICS_H_INCLUDED
+
+#include <cinttypes>
+#include <cmath>
+
+namespace fk {
+
+/**
+ * Streaming mean, variance, minimum and maximum of a series of samples, using
+ * Welford's method so we never have to keep the samples themselves.
+ */
+class RunningStatistics {
+private:
+    uint32_t count_{ 0 };
+    float mean_{ 0.0f };
+    float m2_{ 0.0f };
+    float min_{ 0.0f };
+    float max_{ 0.0f };
+
+public:
+    void clear() {
+        count_ = 0;
+        mean_ = 0.0f;
+        m2_ = 0.0f;
+        min_ = 0.0f;
+        max_ = 0.0f;
+    }
+
+    void add(float value) {
+        if (count_ == 0) {
+            min_ = value;
+            max_ = value;
+        }
+        else {
+            if (value < min_) {
+                min_ = value;
+            }
+            if (value > max_) {
+                max_ = value;
+            }
+        }
+
+        count_++;
+
+        auto delta = value - mean_;
+        mean_ += delta / count_;
+        m2_ += delta * (value - mean_);
+    }
+
+    uint32_t count() const {
+        return count_;
+    }
+
+    float mean() const {
+        return mean_;
+    }
+
+    /**
+     * Sample variance, zero until we have at least two samples.
+     */
+    float variance() const {
+        if (count_ < 2) {
+            return 0.0f;
+        }
+        return m2_ / (count_ - 1);
+    }
+
+    float stddev() const {
+        return sqrtf(variance());
+    }
+
+    float min() const {
+        return min_;
+    }
+
+    float max() const {
+        return max_;
+    }
+
+};
+
+}
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef FK_FAKE_PHYLUM_H_INCLUDED
+#define FK_FAKE_PHYLUM_H_INCLUDED
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * Just enough of phylum's files for the code under test, a file is a buffer
+ * in memory. Reads stop at sector boundaries like the real thing's do, so
+ * callers have to handle short reads.
+ */
+namespace phylum {
+
+constexpr size_t FakeSectorSize = 512;
+
+class File {
+private:
+    const uint8_t *data_{ nullptr };
+    size_t size_{ 0 };
+    size_t position_{ 0 };
+
+public:
+    uint32_t reads{ 0 };
+    uint32_t seeks{ 0 };
+
+public:
+    void open(const uint8_t *data, size_t size) {
+        data_ = data;
+        size_ = size;
+        position_ = 0;
+    }
+
+    bool seek(uint64_t position) {
+        seeks++;
+        if (position > size_) {
+            return false;
+        }
+        position_ = (size_t)position;
+        return true;
+    }
+
+    uint64_t tell() const {
+        return position_;
+    }
+
+    uint64_t size() const {
+        return size_;
+    }
+
+    uint32_t version() const {
+        return 1;
+    }
+
+    size_t read(uint8_t *ptr, size_t size) {
+        auto sector = FakeSectorSize - (position_ % FakeSectorSize);
+        auto n = std::min(std::min(size, sector), size_ - position_);
+        memcpy(ptr, data_ + position_, n);
+        position_ += n;
+        reads++;
+        return n;
+    }
+
+};
+
+class BlockedFile : public File {
+};
+
+class SimpleFile : public File {
+};
+
+}
+
+#endif
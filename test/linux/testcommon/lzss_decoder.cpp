@@ -0,0 +1,50 @@
+#include "lzss_decoder.h"
+#include "lzss.h"
+
+namespace fk {
+
+LzssDecoder::LzssDecoder(std::vector<uint8_t> &output) : output_(output) {
+}
+
+bool LzssDecoder::write(const uint8_t *ptr, size_t size) {
+    for (size_t i = 0; i < size && !failed_; ++i) {
+        auto byte = ptr[i];
+
+        if (items_ == 0) {
+            flags_ = byte;
+            items_ = 8;
+            continue;
+        }
+
+        if (flags_ & 1) {
+            output_.push_back(byte);
+        }
+        else if (!half_) {
+            high_ = byte;
+            half_ = true;
+            continue;
+        }
+        else {
+            auto token = (uint16_t)((high_ << 8) | byte);
+            auto distance = (size_t)(token >> 6) + 1;
+            auto length = (size_t)(token & 0x3f) + LzssMinimumMatch;
+            half_ = false;
+
+            if (distance > output_.size()) {
+                failed_ = true;
+                break;
+            }
+
+            for (size_t j = 0; j < length; ++j) {
+                output_.push_back(output_[output_.size() - distance]);
+            }
+        }
+
+        flags_ >>= 1;
+        items_--;
+    }
+
+    return !failed_;
+}
+
+}
@@ -0,0 +1,40 @@
+#ifndef FK_LZSS_DECODER_H_INCLUDED
+#define FK_LZSS_DECODER_H_INCLUDED
+
+#include <cinttypes>
+#include <cstdlib>
+#include <vector>
+
+namespace fk {
+
+/**
+ * Host side decoder for the compressed downloads and uploads, see lzss.h for
+ * the format. Input may arrive in pieces of any size.
+ */
+class LzssDecoder {
+private:
+    std::vector<uint8_t> &output_;
+    uint8_t flags_{ 0 };
+    uint8_t items_{ 0 };
+    bool half_{ false };
+    uint8_t high_{ 0 };
+    bool failed_{ false };
+
+public:
+    LzssDecoder(std::vector<uint8_t> &output);
+
+public:
+    /**
+     * False if a reference points before the beginning of the output.
+     */
+    bool write(const uint8_t *ptr, size_t size);
+
+    bool failed() const {
+        return failed_;
+    }
+
+};
+
+}
+
+#endif
@@ -0,0 +1,100 @@
+#include "reading_block_decoder.h"
+#include "reading_block.h"
+
+namespace fk {
+
+bool ReadingBlockDecoder::decodeFile(const uint8_t *data, size_t size, std::vector<DecodedReading> &readings) {
+    BlockReader reader{ data, size };
+
+    while (reader.remaining() > 0) {
+        auto length = (size_t)reader.varint();
+        if (reader.failed() || length > reader.remaining()) {
+            return false;
+        }
+
+        if (!decodeRecord(reader.ptr(), length, readings)) {
+            return false;
+        }
+
+        reader.skip(length);
+        records_++;
+    }
+
+    return true;
+}
+
+bool ReadingBlockDecoder::decodeRecord(const uint8_t *data, size_t size, std::vector<DecodedReading> &readings) {
+    BlockReader reader{ data, size };
+
+    while (reader.remaining() > 0) {
+        auto tag = (uint32_t)reader.varint();
+        auto field = tag >> 3;
+        auto type = tag & 0x7;
+
+        switch (type) {
+        case 0: {
+            reader.varint();
+            break;
+        }
+        case 1: {
+            reader.skip(8);
+            break;
+        }
+        case 2: {
+            auto length = (size_t)reader.varint();
+            if (reader.failed() || length > reader.remaining()) {
+                return false;
+            }
+            if (field == ReadingBlockField) {
+                if (!decodeBlock(reader.ptr(), length, readings)) {
+                    return false;
+                }
+            }
+            reader.skip(length);
+            break;
+        }
+        case 5: {
+            reader.skip(4);
+            break;
+        }
+        default: {
+            return false;
+        }
+        }
+
+        if (reader.failed()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+class VectorVisitor : public ReadingBlockVisitor {
+private:
+    std::vector<DecodedReading> *readings_;
+
+public:
+    VectorVisitor(std::vector<DecodedReading> &readings) : readings_(&readings) {
+    }
+
+public:
+    void reading(uint32_t number, uint8_t sensor, uint32_t time, float value) override {
+        readings_->push_back(DecodedReading{ number, sensor, time, value });
+    }
+
+};
+
+bool ReadingBlockDecoder::decodeBlock(const uint8_t *data, size_t size, std::vector<DecodedReading> &readings) {
+    VectorVisitor visitor{ readings };
+
+    if (!reading_block_decode(data, size, visitor)) {
+        return false;
+    }
+
+    blocks_++;
+
+    return true;
+}
+
+}
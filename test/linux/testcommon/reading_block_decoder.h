@@ -0,0 +1,50 @@
+#ifndef FK_READING_BLOCK_DECODER_H_INCLUDED
+#define FK_READING_BLOCK_DECODER_H_INCLUDED
+
+#include <cinttypes>
+#include <cstdlib>
+#include <vector>
+
+namespace fk {
+
+struct DecodedReading {
+    uint32_t reading;
+    uint8_t sensor;
+    uint32_t time;
+    float value;
+};
+
+/**
+ * Host side decoder for the reading blocks DataLogging writes to data.fk, see
+ * reading_block.h for the layout.
+ */
+class ReadingBlockDecoder {
+private:
+    size_t records_{ 0 };
+    size_t blocks_{ 0 };
+
+public:
+    /**
+     * Walks a buffer of delimited data file records, decoding readings from
+     * any blocks and skipping every other record.
+     */
+    bool decodeFile(const uint8_t *data, size_t size, std::vector<DecodedReading> &readings);
+
+    bool decodeBlock(const uint8_t *data, size_t size, std::vector<DecodedReading> &readings);
+
+    size_t records() const {
+        return records_;
+    }
+
+    size_t blocks() const {
+        return blocks_;
+    }
+
+private:
+    bool decodeRecord(const uint8_t *data, size_t size, std::vector<DecodedReading> &readings);
+
+};
+
+}
+
+#endif
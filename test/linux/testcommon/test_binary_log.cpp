@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include "binary_log.h"
+#include "reading_block.h"
+
+using namespace fk;
+
+class BinaryLogSuite : public ::testing::Test {
+protected:
+
+};
+
+static int32_t arguments(uint8_t *buffer, size_t size, const char *f, ...) {
+    va_list args;
+    va_start(args, f);
+    auto bytes = binary_log_arguments(buffer, size, f, args);
+    va_end(args);
+    return bytes;
+}
+
+static bool append(BinaryLog &log, uint32_t uptime, const char *f, ...) {
+    va_list args;
+    va_start(args, f);
+    auto success = log.append(uptime, 0, 2, "Test", f, args);
+    va_end(args);
+    return success;
+}
+
+TEST_F(BinaryLogSuite, Arguments) {
+    uint8_t buffer[64];
+
+    ASSERT_EQ(arguments(buffer, sizeof(buffer), "Nothing 100%%"), 0);
+    ASSERT_EQ(arguments(buffer, sizeof(buffer), "%d %lu", 1, 2ul), 8);
+    ASSERT_EQ(buffer[0], 1);
+    ASSERT_EQ(buffer[4], 2);
+
+    ASSERT_EQ(arguments(buffer, sizeof(buffer), "%.2f", 1.5), 8);
+    double value;
+    memcpy(&value, buffer, sizeof(value));
+    ASSERT_EQ(value, 1.5);
+
+    ASSERT_EQ(arguments(buffer, sizeof(buffer), "'%s' %*d", "abc", 4, 7), 1 + 3 + 4 + 4);
+    ASSERT_EQ(buffer[0], 3);
+    ASSERT_EQ(memcmp(buffer + 1, "abc", 3), 0);
+    ASSERT_EQ(buffer[4], 4);
+    ASSERT_EQ(buffer[8], 7);
+
+    ASSERT_EQ(arguments(buffer, sizeof(buffer), "%llu", 1ull << 40), 8);
+    ASSERT_EQ(buffer[5], 1);
+}
+
+TEST_F(BinaryLogSuite, LongStringsAreTruncated) {
+    uint8_t buffer[128];
+    char string[100];
+    memset(string, 'a', sizeof(string));
+    string[sizeof(string) - 1] = 0;
+
+    ASSERT_EQ(arguments(buffer, sizeof(buffer), "%s", string), 1 + BinaryLogMaximumString);
+    ASSERT_EQ(arguments(buffer, 16, "%s", string), -1);
+}
+
+TEST_F(BinaryLogSuite, Record) {
+    BinaryLog log;
+
+    ASSERT_TRUE(append(log, 100, "Hello %d", 42));
+    ASSERT_TRUE(append(log, 200, "World"));
+    ASSERT_EQ(log.entries(), 2);
+    ASSERT_EQ(log.oldest(), 100);
+
+    size_t size = 0;
+    auto record = log.record(size);
+
+    BlockReader reader{ record, size };
+    auto length = reader.varint();
+    ASSERT_EQ(length, reader.remaining());
+    ASSERT_EQ(reader.varint(), (BinaryLogField << 3) | 2);
+    auto blockLength = reader.varint();
+    ASSERT_EQ(blockLength, reader.remaining());
+    ASSERT_EQ(reader.byte(), BinaryLogVersion);
+    ASSERT_EQ(reader.varint(), 0);
+    ASSERT_EQ(reader.remaining(), (18 + 4) + 18);
+
+    log.clear();
+    ASSERT_EQ(log.entries(), 0);
+    ASSERT_EQ(log.size(), 0);
+}
+
+TEST_F(BinaryLogSuite, DropsWhenFull) {
+    BinaryLog log;
+
+    auto appended = 0;
+    while (append(log, 0, "%s", "some string that takes up room")) {
+        appended++;
+    }
+
+    ASSERT_GT(appended, 0);
+    ASSERT_EQ(log.dropped(), 1);
+    ASSERT_LE(log.size(), BinaryLogBufferSize);
+}
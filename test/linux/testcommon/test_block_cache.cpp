@@ -0,0 +1,325 @@
+#include <chrono>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "block_cache.h"
+#include "tuning.h"
+
+using namespace fk;
+
+constexpr size_t TestSectorSize = 64;
+
+class MemoryStorage : public BlockCacheStorage {
+public:
+    uint8_t data[4][TestSectorSize * 4];
+    uint32_t reads{ 0 };
+    uint32_t writes{ 0 };
+
+public:
+    MemoryStorage() {
+        for (size_t b = 0; b < 4; ++b) {
+            for (size_t i = 0; i < sizeof(data[b]); ++i) {
+                data[b][i] = (uint8_t)(b * 31 + i);
+            }
+        }
+    }
+
+    bool read(uint32_t block, uint32_t position, void *d, size_t n) override {
+        reads++;
+        memcpy(d, &data[block][position], n);
+        return true;
+    }
+
+    bool write(uint32_t block, uint32_t position, const void *d, size_t n) override {
+        writes++;
+        memcpy(&data[block][position], d, n);
+        return true;
+    }
+
+};
+
+class BlockCacheSuite : public ::testing::Test {
+protected:
+    MemoryStorage storage;
+    StaticPool<TestSectorSize * 2> pool{ "BlockCache" };
+
+};
+
+TEST_F(BlockCacheSuite, RepeatedReadsAreHits) {
+    BlockCache<2> cache{ storage, pool, TestSectorSize };
+
+    uint8_t buffer[8];
+    for (auto i = 0; i < 3; ++i) {
+        ASSERT_TRUE(cache.read(1, 10, buffer, sizeof(buffer)));
+        ASSERT_EQ(buffer[0], storage.data[1][10]);
+    }
+
+    ASSERT_EQ(storage.reads, 1);
+    ASSERT_EQ(cache.statistics().misses, 1);
+    ASSERT_EQ(cache.statistics().hits, 2);
+}
+
+TEST_F(BlockCacheSuite, LeastRecentlyUsedIsEvicted) {
+    BlockCache<2> cache{ storage, pool, TestSectorSize };
+
+    uint8_t buffer[8];
+    ASSERT_TRUE(cache.read(0, 0, buffer, sizeof(buffer)));
+    ASSERT_TRUE(cache.read(1, 0, buffer, sizeof(buffer)));
+    ASSERT_TRUE(cache.read(0, 0, buffer, sizeof(buffer)));
+    ASSERT_TRUE(cache.read(2, 0, buffer, sizeof(buffer)));
+    ASSERT_EQ(storage.reads, 3);
+
+    // Block 0 was used more recently than block 1.
+    ASSERT_TRUE(cache.read(0, 0, buffer, sizeof(buffer)));
+    ASSERT_EQ(storage.reads, 3);
+    ASSERT_TRUE(cache.read(1, 0, buffer, sizeof(buffer)));
+    ASSERT_EQ(storage.reads, 4);
+    ASSERT_EQ(cache.statistics().evictions, 2);
+}
+
+TEST_F(BlockCacheSuite, WholeSectorsBypass) {
+    BlockCache<2> cache{ storage, pool, TestSectorSize };
+
+    uint8_t buffer[TestSectorSize * 2];
+    ASSERT_TRUE(cache.read(3, 0, buffer, sizeof(buffer)));
+    ASSERT_EQ(memcmp(buffer, storage.data[3], sizeof(buffer)), 0);
+    ASSERT_EQ(storage.reads, 1);
+    ASSERT_EQ(cache.statistics().bypassed, 1);
+    ASSERT_EQ(cache.statistics().misses, 0);
+}
+
+TEST_F(BlockCacheSuite, WriteThrough) {
+    BlockCache<2> cache{ storage, pool, TestSectorSize };
+
+    uint8_t buffer[4];
+    ASSERT_TRUE(cache.read(2, 4, buffer, sizeof(buffer)));
+
+    uint8_t value[4] = { 1, 2, 3, 4 };
+    ASSERT_TRUE(cache.write(2, 6, value, sizeof(value)));
+    ASSERT_EQ(storage.writes, 1);
+    ASSERT_EQ(storage.data[2][6], 1);
+    ASSERT_EQ(cache.dirty(), 0);
+
+    ASSERT_TRUE(cache.read(2, 4, buffer, sizeof(buffer)));
+    ASSERT_EQ(buffer[2], 1);
+    ASSERT_EQ(buffer[3], 2);
+    ASSERT_EQ(storage.reads, 1);
+}
+
+TEST_F(BlockCacheSuite, WriteBack) {
+    BlockCache<2> cache{ storage, pool, TestSectorSize };
+    cache.writeBack(true);
+
+    uint8_t value[4] = { 1, 2, 3, 4 };
+    ASSERT_TRUE(cache.write(2, 6, value, sizeof(value)));
+    ASSERT_TRUE(cache.write(2, 10, value, sizeof(value)));
+    ASSERT_EQ(storage.writes, 0);
+    ASSERT_EQ(cache.dirty(), 1);
+
+    ASSERT_TRUE(cache.flush());
+    ASSERT_EQ(storage.writes, 1);
+    ASSERT_EQ(storage.data[2][6], 1);
+    ASSERT_EQ(storage.data[2][13], 4);
+    ASSERT_EQ(cache.dirty(), 0);
+}
+
+TEST_F(BlockCacheSuite, ErasedBlocksAreForgotten) {
+    BlockCache<2> cache{ storage, pool, TestSectorSize };
+    cache.writeBack(true);
+
+    uint8_t value[4] = { 1, 2, 3, 4 };
+    ASSERT_TRUE(cache.write(1, 0, value, sizeof(value)));
+    cache.erased(1);
+    ASSERT_EQ(cache.dirty(), 0);
+    ASSERT_TRUE(cache.flush());
+    ASSERT_EQ(storage.writes, 0);
+}
+
+TEST_F(BlockCacheSuite, SequentialReadsAreReadAhead) {
+    StaticPool<TestSectorSize * 4> pool{ "BlockCache" };
+    BlockCache<2, 2> cache{ storage, pool, TestSectorSize };
+    cache.sectorsPerBlock(4);
+
+    // The first goes straight through, after that they're read in runs.
+    uint8_t buffer[TestSectorSize];
+    for (size_t sector = 0; sector < 4; ++sector) {
+        ASSERT_TRUE(cache.read(1, sector * TestSectorSize, buffer, sizeof(buffer)));
+        ASSERT_EQ(memcmp(buffer, &storage.data[1][sector * TestSectorSize], sizeof(buffer)), 0);
+    }
+    ASSERT_EQ(storage.reads, 3);
+    ASSERT_EQ(cache.statistics().runs, 2);
+    ASSERT_EQ(cache.statistics().batched, 3);
+
+    // Runs stop at the end of the block.
+    ASSERT_TRUE(cache.read(2, 0, buffer, sizeof(buffer)));
+    ASSERT_EQ(memcmp(buffer, storage.data[2], sizeof(buffer)), 0);
+    ASSERT_EQ(storage.reads, 4);
+}
+
+TEST_F(BlockCacheSuite, ReadAheadIsDroppedWhenWritten) {
+    StaticPool<TestSectorSize * 4> pool{ "BlockCache" };
+    BlockCache<2, 2> cache{ storage, pool, TestSectorSize };
+    cache.sectorsPerBlock(4);
+
+    uint8_t buffer[TestSectorSize];
+    ASSERT_TRUE(cache.read(1, 0, buffer, sizeof(buffer)));
+    ASSERT_TRUE(cache.read(1, TestSectorSize, buffer, sizeof(buffer)));
+
+    // Sector two is in the run, a small write there has to be seen.
+    uint8_t value[4] = { 1, 2, 3, 4 };
+    ASSERT_TRUE(cache.write(1, TestSectorSize * 2 + 8, value, sizeof(value)));
+    ASSERT_TRUE(cache.read(1, TestSectorSize * 2, buffer, sizeof(buffer)));
+    ASSERT_EQ(buffer[8], 1);
+    ASSERT_EQ(buffer[11], 4);
+}
+
+TEST_F(BlockCacheSuite, SequentialWritesAreGathered) {
+    StaticPool<TestSectorSize * 4> pool{ "BlockCache" };
+    BlockCache<2, 2> cache{ storage, pool, TestSectorSize };
+    cache.sectorsPerBlock(4);
+
+    uint8_t sectors[3][TestSectorSize];
+    for (size_t i = 0; i < 3; ++i) {
+        memset(sectors[i], 0x10 + i, TestSectorSize);
+    }
+
+    ASSERT_TRUE(cache.write(2, 0, sectors[0], TestSectorSize));
+    ASSERT_EQ(storage.writes, 0);
+    ASSERT_TRUE(cache.write(2, TestSectorSize, sectors[1], TestSectorSize));
+    ASSERT_EQ(storage.writes, 1);
+    ASSERT_EQ(storage.data[2][TestSectorSize], 0x11);
+
+    // Reads see what's waiting to be written.
+    ASSERT_TRUE(cache.write(2, TestSectorSize * 2, sectors[2], TestSectorSize));
+    ASSERT_EQ(storage.writes, 1);
+    uint8_t buffer[4];
+    ASSERT_TRUE(cache.read(2, TestSectorSize * 2 + 4, buffer, sizeof(buffer)));
+    ASSERT_EQ(buffer[0], 0x12);
+
+    ASSERT_TRUE(cache.flush());
+    ASSERT_EQ(storage.writes, 2);
+    ASSERT_EQ(storage.data[2][TestSectorSize * 2], 0x12);
+    ASSERT_EQ(cache.statistics().runs, 2);
+}
+
+TEST_F(BlockCacheSuite, GatheredWritesAreWrittenBeforeOverlappingOnes) {
+    StaticPool<TestSectorSize * 4> pool{ "BlockCache" };
+    BlockCache<2, 2> cache{ storage, pool, TestSectorSize };
+    cache.sectorsPerBlock(4);
+
+    uint8_t sector[TestSectorSize];
+    memset(sector, 0x20, sizeof(sector));
+    ASSERT_TRUE(cache.write(3, 0, sector, sizeof(sector)));
+
+    uint8_t value[4] = { 1, 2, 3, 4 };
+    ASSERT_TRUE(cache.write(3, 4, value, sizeof(value)));
+    ASSERT_EQ(storage.writes, 2);
+    ASSERT_EQ(storage.data[3][0], 0x20);
+    ASSERT_EQ(storage.data[3][4], 1);
+}
+
+TEST_F(BlockCacheSuite, ErasedBlocksLoseGatheredWrites) {
+    StaticPool<TestSectorSize * 4> pool{ "BlockCache" };
+    BlockCache<2, 2> cache{ storage, pool, TestSectorSize };
+    cache.sectorsPerBlock(4);
+
+    uint8_t sector[TestSectorSize];
+    memset(sector, 0x30, sizeof(sector));
+    ASSERT_TRUE(cache.write(1, 0, sector, sizeof(sector)));
+    cache.erased(1);
+    ASSERT_TRUE(cache.flush());
+    ASSERT_EQ(storage.writes, 0);
+}
+
+/**
+ * Memory with a fixed cost for every request, like the command and the
+ * wait for the card that come with each one over SPI.
+ */
+class CommandStorage : public BlockCacheStorage {
+public:
+    static constexpr size_t SectorSize = 512;
+    static constexpr size_t SectorsPerBlock = 16;
+    static constexpr size_t Blocks = 32;
+
+public:
+    std::vector<uint8_t> data;
+    std::chrono::microseconds overhead;
+    uint32_t requests{ 0 };
+
+public:
+    CommandStorage(std::chrono::microseconds overhead) : data(Blocks * SectorsPerBlock * SectorSize), overhead(overhead) {
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i] = (uint8_t)(i * 13);
+        }
+    }
+
+    bool read(uint32_t block, uint32_t position, void *d, size_t n) override {
+        command();
+        memcpy(d, &data[block * SectorsPerBlock * SectorSize + position], n);
+        return true;
+    }
+
+    bool write(uint32_t block, uint32_t position, const void *d, size_t n) override {
+        command();
+        memcpy(&data[block * SectorsPerBlock * SectorSize + position], d, n);
+        return true;
+    }
+
+private:
+    void command() {
+        requests++;
+        auto until = std::chrono::steady_clock::now() + overhead;
+        while (std::chrono::steady_clock::now() < until) {
+        }
+    }
+
+};
+
+/**
+ * Reads half the storage a sector at a time, as a download does, then
+ * writes it to the other half, as appends do. Returns MB/s.
+ */
+template<size_t R>
+static double read_then_write(CommandStorage &storage) {
+    StaticPool<CommandStorage::SectorSize * (4 + R)> pool{ "BlockCache" };
+    BlockCache<4, R> cache{ storage, pool, CommandStorage::SectorSize };
+    cache.sectorsPerBlock(CommandStorage::SectorsPerBlock);
+
+    auto half = storage.data.size() / 2;
+    std::vector<uint8_t> copy(half);
+
+    auto started = std::chrono::steady_clock::now();
+    for (size_t position = 0; position < half; position += CommandStorage::SectorSize) {
+        auto block = position / (CommandStorage::SectorsPerBlock * CommandStorage::SectorSize);
+        auto offset = position % (CommandStorage::SectorsPerBlock * CommandStorage::SectorSize);
+        EXPECT_TRUE(cache.read(block, offset, &copy[position], CommandStorage::SectorSize));
+    }
+    for (size_t position = 0; position < half; position += CommandStorage::SectorSize) {
+        auto block = CommandStorage::Blocks / 2 + position / (CommandStorage::SectorsPerBlock * CommandStorage::SectorSize);
+        auto offset = position % (CommandStorage::SectorsPerBlock * CommandStorage::SectorSize);
+        EXPECT_TRUE(cache.write(block, offset, &copy[position], CommandStorage::SectorSize));
+    }
+    EXPECT_TRUE(cache.flush());
+    auto finished = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(memcmp(storage.data.data(), storage.data.data() + half, half), 0);
+
+    return (double)half * 2 / (1024.0 * 1024.0) / std::chrono::duration<double>(finished - started).count();
+}
+
+TEST_F(BlockCacheSuite, RunsThroughput) {
+    auto overhead = std::chrono::microseconds(20);
+
+    CommandStorage a{ overhead };
+    auto singleSpeed = read_then_write<0>(a);
+
+    CommandStorage b{ overhead };
+    auto batchedSpeed = read_then_write<BlockCacheRunSectors>(b);
+
+    ASSERT_EQ(a.requests, CommandStorage::Blocks * CommandStorage::SectorsPerBlock);
+    ASSERT_LT(b.requests, a.requests / 2);
+
+    printf("block cache: %u requests %.1f MB/s, %u requests in runs of %zu %.1f MB/s\n",
+           a.requests, singleSpeed, b.requests, BlockCacheRunSectors, batchedSpeed);
+}
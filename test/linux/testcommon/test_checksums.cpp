@@ -0,0 +1,99 @@
+#include <chrono>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "checksums.h"
+
+using namespace fk;
+
+#if defined(FK_CRC32_SLICE_BY_8)
+static constexpr const char *Variant = "slice by 8";
+#elif defined(FK_CRC32_SLICE_BY_4)
+static constexpr const char *Variant = "slice by 4";
+#else
+static constexpr const char *Variant = "nibble";
+#endif
+
+class ChecksumsSuite : public ::testing::Test {
+protected:
+    std::vector<uint8_t> random(size_t size) {
+        std::vector<uint8_t> data(size);
+        uint32_t x = 2463534242;
+        for (auto &b : data) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            b = (uint8_t)x;
+        }
+        return data;
+    }
+
+    uint32_t bytewise(uint32_t crc, const uint8_t *ptr, size_t size) {
+        while (size-- > 0) {
+            crc = crc32_update(crc, *(ptr++));
+        }
+        return crc;
+    }
+
+};
+
+TEST_F(ChecksumsSuite, CheckValue) {
+    uint8_t data[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+
+    ASSERT_EQ(crc32_checksum(data, sizeof(data)), 0xcbf43926);
+}
+
+TEST_F(ChecksumsSuite, BulkMatchesBytewise) {
+    auto data = random(1024);
+
+    // Every alignment and length, including the odd bytes either side.
+    for (size_t offset = 0; offset < 8; ++offset) {
+        for (size_t size = 0; size < 100; ++size) {
+            auto ptr = data.data() + offset;
+            ASSERT_EQ(crc32_update(~0, ptr, size), bytewise(~0, ptr, size));
+        }
+    }
+}
+
+TEST_F(ChecksumsSuite, UpdatesInPieces) {
+    auto data = random(1000);
+
+    auto whole = crc32_update(~0, data.data(), data.size());
+    auto crc = crc32_update(~0, data.data(), 333);
+    crc = crc32_update(crc, data.data() + 333, 1);
+    crc = crc32_update(crc, data.data() + 334, data.size() - 334);
+
+    ASSERT_EQ(crc, whole);
+}
+
+TEST_F(ChecksumsSuite, Throughput) {
+    auto data = random(64 * 1024);
+    auto passes = 64;
+
+    auto started = std::chrono::steady_clock::now();
+    uint32_t a = ~0;
+    for (auto i = 0; i < passes; ++i) {
+        a = bytewise(a, data.data(), data.size());
+    }
+    auto middle = std::chrono::steady_clock::now();
+    uint32_t b = ~0;
+    for (auto i = 0; i < passes; ++i) {
+        b = crc32_update(b, data.data(), data.size());
+    }
+    auto finished = std::chrono::steady_clock::now();
+
+    ASSERT_EQ(a, b);
+
+    auto megabytes = (double)data.size() * passes / (1024.0 * 1024.0);
+    auto bytewiseSeconds = std::chrono::duration<double>(middle - started).count();
+    auto bulkSeconds = std::chrono::duration<double>(finished - middle).count();
+
+    printf("crc32: bytewise %.1f MB/s, bulk (%s) %.1f MB/s\n", megabytes / bytewiseSeconds, Variant, megabytes / bulkSeconds);
+
+    // The default bulk update is the bytewise nibble loop, only the larger
+    // tables have anything to beat.
+    #if defined(FK_CRC32_SLICE_BY_4) || defined(FK_CRC32_SLICE_BY_8)
+    ASSERT_LT(bulkSeconds, bytewiseSeconds);
+    #endif
+}
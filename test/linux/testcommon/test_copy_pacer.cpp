@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include "copy_pacer.h"
+
+using namespace fk;
+
+class CopyPacerSuite : public ::testing::Test {
+protected:
+
+};
+
+TEST_F(CopyPacerSuite, HistogramBuckets) {
+    Log2Histogram<4> histogram;
+
+    histogram.add(0);
+    histogram.add(1);
+    histogram.add(3);
+    histogram.add(4);
+    histogram.add(1000);
+
+    ASSERT_EQ(histogram.get(0), 1);
+    ASSERT_EQ(histogram.get(1), 1);
+    ASSERT_EQ(histogram.get(2), 1);
+    ASSERT_EQ(histogram.get(3), 2);
+}
+
+TEST_F(CopyPacerSuite, QuickWritesGrowChunksAndSlices) {
+    CopyPacer pacer;
+    pacer.begin();
+
+    for (auto i = 0; i < 10; ++i) {
+        ASSERT_TRUE(pacer.wrote(pacer.chunk(), 1));
+    }
+    ASSERT_EQ(pacer.chunk(), FileCopyTransferSize);
+
+    for (auto i = 0; i < 10; ++i) {
+        pacer.sliced(FileCopyTransferSize * 10, pacer.slice());
+    }
+    ASSERT_EQ(pacer.slice(), FileCopyMaximumElapsed);
+}
+
+TEST_F(CopyPacerSuite, StallsShrinkChunksAndSlices) {
+    CopyPacer pacer;
+    pacer.begin();
+
+    for (auto i = 0; i < 10; ++i) {
+        pacer.wrote(pacer.chunk(), 1);
+        pacer.sliced(pacer.chunk(), pacer.slice());
+    }
+    auto chunk = pacer.chunk();
+    auto slice = pacer.slice();
+
+    ASSERT_FALSE(pacer.wrote(512, FileCopyStallThreshold));
+    pacer.sliced(512, slice);
+
+    ASSERT_EQ(pacer.chunk(), chunk / 2);
+    ASSERT_EQ(pacer.slice(), slice / 2);
+    ASSERT_EQ(pacer.stalls().get(7), 1);
+
+    // Never below the minimums.
+    for (auto i = 0; i < 20; ++i) {
+        pacer.stalled();
+        pacer.sliced(0, 1);
+    }
+    ASSERT_EQ(pacer.chunk(), FileCopyMinimumChunk);
+    ASSERT_EQ(pacer.slice(), FileCopyMinimumSlice);
+}
+
+TEST_F(CopyPacerSuite, BlockedWriterIsAStall) {
+    CopyPacer pacer;
+    pacer.begin();
+
+    ASSERT_FALSE(pacer.wrote(0, 0));
+    ASSERT_EQ(pacer.stalls().get(0), 1);
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+
+#include "data_index.h"
+
+using namespace fk;
+
+class DataIndexSuite : public ::testing::Test {
+protected:
+
+};
+
+TEST_F(DataIndexSuite, Empty) {
+    DataIndex<8> index{ 100 };
+
+    ASSERT_EQ(index.begin(1000), 0);
+    ASSERT_EQ(index.end(1000), 0);
+}
+
+TEST_F(DataIndexSuite, EntriesEveryStride) {
+    DataIndex<8> index{ 100 };
+
+    ASSERT_TRUE(index.append(1000, 1, 0));
+    ASSERT_FALSE(index.append(1010, 1, 50));
+    ASSERT_TRUE(index.append(1020, 2, 100));
+    ASSERT_FALSE(index.append(1030, 2, 150));
+    ASSERT_TRUE(index.append(1040, 3, 210));
+
+    ASSERT_EQ(index.size(), 3);
+
+    // Records between entries are included.
+    ASSERT_EQ(index.begin(1030), 100);
+    ASSERT_EQ(index.begin(1020), 100);
+    ASSERT_EQ(index.begin(500), 0);
+    ASSERT_EQ(index.begin(5000), 210);
+
+    ASSERT_EQ(index.end(1020), 210);
+    ASSERT_EQ(index.end(5000), 0);
+
+    ASSERT_EQ(index.beginReading(3), 100);
+    ASSERT_EQ(index.beginReading(2), 0);
+}
+
+TEST_F(DataIndexSuite, FullIndexDoublesStride) {
+    DataIndex<8> index{ 100 };
+
+    for (uint32_t i = 0; i < 64; ++i) {
+        index.append(1000 + i * 10, i, i * 100);
+    }
+
+    ASSERT_LE(index.size(), 8);
+    ASSERT_GT(index.stride(), 100);
+    ASSERT_EQ(index.get(0).position, 0);
+
+    for (size_t i = 1; i < index.size(); ++i) {
+        ASSERT_GT(index.get(i).time, index.get(i - 1).time);
+        ASSERT_GT(index.get(i).position, index.get(i - 1).position);
+    }
+
+    // Still conservative, never past the first record in range.
+    for (uint32_t t = 1000; t < 1640; t += 5) {
+        auto position = index.begin(t);
+        ASSERT_LE(position, ((t - 1000 + 9) / 10) * 100);
+    }
+}
+
+TEST_F(DataIndexSuite, BufferedReadingsStayInRange) {
+    DataIndex<8> index{ 100 };
+
+    index.append(5000, 1, 0);
+    index.append(5010, 2, 100);
+    // Buffered readings from well before the others.
+    index.append(1000, 3, 200);
+    index.append(5020, 4, 300);
+
+    ASSERT_EQ(index.size(), 4);
+
+    // Everything from 1000 on, including the buffered ones.
+    ASSERT_LE(index.begin(1000), 200);
+    // Nothing after 5010 comes before the entry at 300.
+    ASSERT_EQ(index.begin(5011), 300);
+}
+
+TEST_F(DataIndexSuite, RestoringReproducesLookups) {
+    DataIndex<8> index{ 100 };
+
+    for (uint32_t i = 0; i < 40; ++i) {
+        index.append(1000 + i * 10, i, i * 100);
+    }
+
+    DataIndex<8> restored{ 100 };
+    restored.clear(index.stride());
+    for (size_t i = 0; i < index.size(); ++i) {
+        ASSERT_TRUE(restored.restore(index.get(i)));
+    }
+
+    ASSERT_EQ(restored.size(), index.size());
+    ASSERT_EQ(restored.stride(), index.stride());
+    for (uint32_t t = 900; t < 1500; t += 7) {
+        ASSERT_EQ(restored.begin(t), index.begin(t));
+        ASSERT_EQ(restored.end(t), index.end(t));
+    }
+
+    // Carries on as the original would have.
+    ASSERT_EQ(restored.append(1400, 40, 4000), index.append(1400, 40, 4000));
+    ASSERT_EQ(restored.size(), index.size());
+}
+
+TEST_F(DataIndexSuite, SavingTracksNewEntries) {
+    DataIndex<4> index{ 100 };
+
+    ASSERT_TRUE(index.dirty());
+    ASSERT_TRUE(index.rewrite());
+
+    index.append(1000, 1, 0);
+    index.markSaved();
+    ASSERT_FALSE(index.dirty());
+
+    index.append(1010, 2, 100);
+    ASSERT_TRUE(index.dirty());
+    ASSERT_FALSE(index.rewrite());
+    ASSERT_EQ(index.saved(), 1);
+    index.markSaved();
+
+    // Filling up thins the entries out, so they're all saved again.
+    index.append(1020, 3, 200);
+    index.append(1030, 4, 300);
+    index.markSaved();
+    index.append(1040, 5, 400);
+    ASSERT_TRUE(index.rewrite());
+}
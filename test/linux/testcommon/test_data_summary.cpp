@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "data_summary.h"
+
+using namespace fk;
+
+class DataSummarySuite : public ::testing::Test {
+protected:
+
+};
+
+struct Cell {
+    uint32_t count;
+    float minimum;
+    float mean;
+    float maximum;
+};
+
+static uint32_t get32(const std::vector<uint8_t> &data, size_t offset) {
+    uint32_t value = 0;
+    for (auto i = 0; i < 4; ++i) {
+        value |= (uint32_t)data[offset + i] << (i * 8);
+    }
+    return value;
+}
+
+static float getFloat(const std::vector<uint8_t> &data, size_t offset) {
+    auto bits = get32(data, offset);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static Cell cell(const std::vector<uint8_t> &data, size_t sensors, size_t bucket, size_t sensor) {
+    auto offset = DataSummaryHeaderSize + (bucket * sensors + sensor) * DataSummaryCellSize;
+    return Cell{ get32(data, offset), getFloat(data, offset + 4), getFloat(data, offset + 8), getFloat(data, offset + 12) };
+}
+
+template<size_t N>
+static void drain(DataSummary<N> &summary, std::vector<uint8_t> &data) {
+    uint8_t buffer[7];
+    while (true) {
+        auto bytes = summary.read(buffer, sizeof(buffer));
+        if (bytes == 0) {
+            break;
+        }
+        data.insert(data.end(), buffer, buffer + bytes);
+    }
+}
+
+template<size_t N>
+static void add(DataSummary<N> &summary, std::vector<uint8_t> &data, uint8_t sensor, uint32_t time, float value) {
+    while (!summary.add(sensor, time, value)) {
+        drain(summary, data);
+    }
+}
+
+TEST_F(DataSummarySuite, Buckets) {
+    DataSummary<4> summary;
+    std::vector<uint8_t> data;
+
+    summary.begin(1000, 1400, 100, 2);
+    ASSERT_EQ(summary.buckets(), 4);
+    ASSERT_EQ(summary.size(), DataSummaryHeaderSize + 4 * 2 * DataSummaryCellSize);
+
+    add(summary, data, 0, 1000, 1.0f);
+    add(summary, data, 0, 1050, 3.0f);
+    add(summary, data, 1, 1060, 10.0f);
+    add(summary, data, 0, 1310, 5.0f);
+    add(summary, data, 0, 1320, 7.0f);
+
+    summary.finish();
+    drain(summary, data);
+
+    ASSERT_TRUE(summary.done());
+    ASSERT_EQ(data.size(), summary.size());
+    ASSERT_EQ(data[0], DataSummaryVersion);
+    ASSERT_EQ(data[1], 2);
+    ASSERT_EQ(get32(data, 4), 1000);
+    ASSERT_EQ(get32(data, 8), 100);
+
+    auto first = cell(data, 2, 0, 0);
+    ASSERT_EQ(first.count, 2);
+    ASSERT_FLOAT_EQ(first.minimum, 1.0f);
+    ASSERT_FLOAT_EQ(first.mean, 2.0f);
+    ASSERT_FLOAT_EQ(first.maximum, 3.0f);
+
+    ASSERT_EQ(cell(data, 2, 0, 1).count, 1);
+    ASSERT_EQ(cell(data, 2, 1, 0).count, 0);
+    ASSERT_EQ(cell(data, 2, 2, 0).count, 0);
+
+    auto last = cell(data, 2, 3, 0);
+    ASSERT_EQ(last.count, 2);
+    ASSERT_FLOAT_EQ(last.mean, 6.0f);
+}
+
+TEST_F(DataSummarySuite, LateAndOutside) {
+    DataSummary<4> summary;
+    std::vector<uint8_t> data;
+
+    summary.begin(1000, 1400, 100, 2);
+
+    add(summary, data, 0, 900, 1.0f);
+    add(summary, data, 0, 1500, 1.0f);
+    add(summary, data, 3, 1100, 1.0f);
+    add(summary, data, 0, 1210, 1.0f);
+    add(summary, data, 0, 1010, 1.0f);
+
+    summary.finish();
+    drain(summary, data);
+
+    ASSERT_EQ(summary.outside(), 3);
+    ASSERT_EQ(summary.late(), 1);
+    ASSERT_EQ(data.size(), summary.size());
+}
+
+TEST_F(DataSummarySuite, SizeDependsOnlyOnBuckets) {
+    DataSummary<4> summary;
+    std::vector<uint8_t> data;
+
+    summary.begin(0, 100000, 1000, 1);
+
+    for (uint32_t t = 0; t < 100000; t += 10) {
+        add(summary, data, 0, t, (float)t);
+    }
+
+    summary.finish();
+    drain(summary, data);
+
+    ASSERT_EQ(data.size(), DataSummaryHeaderSize + 100 * DataSummaryCellSize);
+    ASSERT_EQ(cell(data, 1, 50, 0).count, 100);
+}
+
+TEST_F(DataSummarySuite, MaximumBucketsKeepsRecent) {
+    DataSummary<4> summary;
+
+    summary.begin(0, DataSummaryMaximumBuckets * 20, 10, 1);
+
+    ASSERT_EQ(summary.buckets(), DataSummaryMaximumBuckets);
+    ASSERT_EQ(summary.start(), DataSummaryMaximumBuckets * 10);
+}
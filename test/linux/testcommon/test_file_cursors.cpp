@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include "file_cursor_table.h"
+
+using namespace fk;
+
+class FileCursorsSuite : public ::testing::Test {
+protected:
+
+};
+
+TEST_F(FileCursorsSuite, DeltaRoundTrip) {
+    uint8_t buffer[FileCursorDeltaSize];
+
+    FileCursorTable::encode(buffer, FileNumber::Data, 1500000000, 123456);
+
+    FileNumber file;
+    uint32_t time;
+    uint32_t position;
+    ASSERT_TRUE(FileCursorTable::decode(buffer, file, time, position));
+    ASSERT_EQ(file, FileNumber::Data);
+    ASSERT_EQ(time, 1500000000);
+    ASSERT_EQ(position, 123456);
+}
+
+TEST_F(FileCursorsSuite, CorruptDeltasAreRejected) {
+    uint8_t buffer[FileCursorDeltaSize];
+
+    FileCursorTable::encode(buffer, FileNumber::Data, 1500000000, 123456);
+    buffer[13] ^= 0x10;
+
+    FileNumber file;
+    uint32_t time;
+    uint32_t position;
+    ASSERT_FALSE(FileCursorTable::decode(buffer, file, time, position));
+
+    // Whatever happens to be at the end of an old snapshot.
+    memset(buffer, 0, sizeof(buffer));
+    ASSERT_FALSE(FileCursorTable::decode(buffer, file, time, position));
+}
+
+TEST_F(FileCursorsSuite, SnapshotRoundTrip) {
+    FileCursorTable table;
+
+    table.set(FileNumber::Data, 100, 4096);
+    table.set(FileNumber::LogsA, 200, 512);
+
+    FileCursors snapshot;
+    table.snapshot(snapshot);
+    ASSERT_EQ(snapshot.cursors[(size_t)FileNumber::Data].position, 4096);
+
+    FileCursorTable restored;
+    restored.restore(snapshot);
+    ASSERT_EQ(restored.position(FileNumber::Data), 4096);
+    ASSERT_EQ(restored.time(FileNumber::LogsA), 200);
+    ASSERT_EQ(restored.position(FileNumber::System), 0);
+}
+
+TEST_F(FileCursorsSuite, SnapshotLayoutIsUnchanged) {
+    // Older firmware wrote these, we still need to read them.
+    ASSERT_EQ(sizeof(FileCursor), 88);
+    ASSERT_EQ(sizeof(FileCursors), 88 * FileSystemNumberOfFiles);
+}
+
+TEST_F(FileCursorsSuite, BasesAreKeptInSnapshots) {
+    FileCursorTable table;
+
+    table.base(FileNumber::Data, 8 * 1024 * 1024);
+    table.set(FileNumber::Data, 100, 8 * 1024 * 1024 + 512);
+
+    FileCursors snapshot;
+    table.snapshot(snapshot);
+
+    FileCursorTable restored;
+    restored.restore(snapshot);
+    ASSERT_EQ(restored.base(FileNumber::Data), 8 * 1024 * 1024);
+    ASSERT_EQ(restored.position(FileNumber::Data), 8 * 1024 * 1024 + 512);
+    ASSERT_EQ(restored.base(FileNumber::LogsA), 0);
+
+    // Older snapshots had zeros where the base is now.
+    memset(&snapshot.cursors[(size_t)FileNumber::Data].base, 0, sizeof(uint32_t));
+    restored.restore(snapshot);
+    ASSERT_EQ(restored.base(FileNumber::Data), 0);
+}
+
+TEST_F(FileCursorsSuite, IndexRecordsAreNotDeltas) {
+    uint8_t buffer[FileCursorDeltaSize];
+    uint32_t stride;
+    DataIndexEntry entry;
+    FileNumber file;
+    uint32_t time;
+    uint32_t position;
+
+    FileCursorTable::encodeIndexReset(buffer, 8192);
+    ASSERT_FALSE(FileCursorTable::decode(buffer, file, time, position));
+    ASSERT_EQ(FileCursorTable::decodeIndex(buffer, stride, entry), FileIndexRecord::Reset);
+    ASSERT_EQ(stride, 8192);
+
+    FileCursorTable::encodeIndexEntry(buffer, DataIndexEntry{ 1500000000, 42, 123456 });
+    ASSERT_FALSE(FileCursorTable::decode(buffer, file, time, position));
+    ASSERT_EQ(FileCursorTable::decodeIndex(buffer, stride, entry), FileIndexRecord::Entry);
+    ASSERT_EQ(entry.time, 1500000000);
+    ASSERT_EQ(entry.reading, 42);
+    ASSERT_EQ(entry.position, 123456);
+
+    FileCursorTable::encode(buffer, FileNumber::Data, 1500000000, 123456);
+    ASSERT_EQ(FileCursorTable::decodeIndex(buffer, stride, entry), FileIndexRecord::None);
+}
+
+TEST_F(FileCursorsSuite, ErasesOwedAreKeptInSnapshots) {
+    FileCursorTable table;
+
+    table.erasing(FileNumber::Data, true);
+    ASSERT_TRUE(table.erasing(FileNumber::Data));
+    ASSERT_FALSE(table.erasing(FileNumber::LogsA));
+
+    FileCursors snapshot;
+    table.snapshot(snapshot);
+
+    FileCursorTable restored;
+    restored.restore(snapshot);
+    ASSERT_TRUE(restored.erasing(FileNumber::Data));
+    ASSERT_FALSE(restored.erasing(FileNumber::LogsA));
+
+    restored.erasing(FileNumber::Data, false);
+    restored.snapshot(snapshot);
+    ASSERT_EQ(snapshot.cursors[(size_t)FileNumber::Data].erasing, 0);
+}
@@ -0,0 +1,193 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "file_reader.h"
+
+using namespace fk;
+
+class FileReaderSuite : public ::testing::Test {
+protected:
+    std::vector<uint8_t> data;
+    phylum::SimpleFile file;
+    StaticPool<1024> pool{ "FileReader" };
+
+protected:
+    void SetUp() override {
+        for (size_t i = 0; i < 2000; ++i) {
+            data.push_back((uint8_t)(i * 7 + (i >> 8)));
+        }
+        file.open(data.data(), data.size());
+    }
+
+    /**
+     * Reads size bytes and checks they're the file's from position.
+     */
+    void expect(FileReader &reader, size_t position, size_t size) {
+        std::vector<uint8_t> buffer(size);
+        ASSERT_EQ(reader.read(buffer.data(), size), (int32_t)size);
+        ASSERT_EQ(buffer, std::vector<uint8_t>(data.begin() + position, data.begin() + position + size));
+    }
+
+};
+
+TEST_F(FileReaderSuite, ReadsWithoutReadAhead) {
+    FileReader reader{ file };
+    ASSERT_TRUE(reader.open(0, 0));
+    ASSERT_EQ(reader.size(), data.size());
+
+    expect(reader, 0, 100);
+    ASSERT_EQ(reader.tell(), (size_t)100);
+    ASSERT_FALSE(reader.prefetch());
+    ASSERT_EQ(reader.buffered(), (size_t)0);
+}
+
+TEST_F(FileReaderSuite, InterleavedPrefetchAndRead) {
+    FileReader reader{ file };
+    reader.readAhead(pool, 256);
+    ASSERT_TRUE(reader.open(0, 0));
+
+    // Nothing's been read, so the first prefetch fills the front.
+    ASSERT_TRUE(reader.prefetch());
+    ASSERT_EQ(reader.buffered(), (size_t)256);
+    ASSERT_EQ(reader.tell(), (size_t)0);
+
+    // The back fills while the front's still being read from.
+    expect(reader, 0, 100);
+    ASSERT_TRUE(reader.prefetch());
+    ASSERT_EQ(reader.buffered(), (size_t)(156 + 256));
+    ASSERT_EQ(reader.tell(), (size_t)100);
+
+    // Both are full, so there's nothing to do.
+    auto reads = file.reads;
+    ASSERT_TRUE(reader.prefetch());
+    ASSERT_EQ(file.reads, reads);
+
+    // Across both buffers, then straight from the file for the rest.
+    expect(reader, 100, 500);
+    ASSERT_EQ(reader.buffered(), (size_t)0);
+    ASSERT_EQ(reader.tell(), (size_t)600);
+
+    ASSERT_TRUE(reader.prefetch());
+    expect(reader, 600, 10);
+    ASSERT_TRUE(reader.prefetch());
+    expect(reader, 610, 502);
+    ASSERT_EQ(reader.tell(), (size_t)1112);
+}
+
+TEST_F(FileReaderSuite, PartiallyConsumedBuffersAreKept) {
+    FileReader reader{ file };
+    reader.readAhead(pool, 256);
+    ASSERT_TRUE(reader.open(0, 0));
+
+    ASSERT_TRUE(reader.prefetch());
+    for (size_t i = 0; i < 256; i += 32) {
+        expect(reader, i, 32);
+        ASSERT_EQ(reader.buffered(), 256 - i - 32);
+        ASSERT_EQ(reader.tell(), i + 32);
+    }
+
+    // The front's used up, so this refills it rather than the back.
+    ASSERT_TRUE(reader.prefetch());
+    ASSERT_EQ(reader.buffered(), (size_t)256);
+    expect(reader, 256, 256);
+}
+
+TEST_F(FileReaderSuite, SeekingDiscardsWhatsBuffered) {
+    FileReader reader{ file };
+    reader.readAhead(pool, 256);
+    ASSERT_TRUE(reader.open(0, 0));
+
+    ASSERT_TRUE(reader.prefetch());
+    expect(reader, 0, 10);
+    ASSERT_TRUE(reader.prefetch());
+    ASSERT_GT(reader.buffered(), (size_t)0);
+
+    ASSERT_TRUE(reader.seek(1000));
+    ASSERT_EQ(reader.buffered(), (size_t)0);
+    ASSERT_EQ(reader.tell(), (size_t)1000);
+    expect(reader, 1000, 50);
+
+    ASSERT_TRUE(reader.prefetch());
+    ASSERT_TRUE(reader.seek(20));
+    expect(reader, 20, 300);
+}
+
+TEST_F(FileReaderSuite, EndOfFile) {
+    FileReader reader{ file };
+    reader.readAhead(pool, 256);
+    ASSERT_TRUE(reader.open(1900, 0));
+    ASSERT_EQ(reader.size(), data.size());
+    ASSERT_FALSE(reader.isFinished());
+
+    ASSERT_TRUE(reader.prefetch());
+    ASSERT_EQ(reader.buffered(), (size_t)100);
+    ASSERT_FALSE(reader.prefetch());
+    ASSERT_EQ(reader.buffered(), (size_t)100);
+    ASSERT_FALSE(reader.isFinished());
+
+    uint8_t buffer[256];
+    ASSERT_EQ(reader.read(buffer, sizeof(buffer)), 100);
+    ASSERT_TRUE(reader.isFinished());
+    ASSERT_EQ(reader.read(buffer, sizeof(buffer)), (int32_t)lws::Stream::EOS);
+    ASSERT_FALSE(reader.prefetch());
+}
+
+TEST_F(FileReaderSuite, EndOfRange) {
+    FileReader reader{ file };
+    reader.readAhead(pool, 256);
+    ASSERT_TRUE(reader.open(100, 300));
+    ASSERT_EQ(reader.size(), (size_t)400);
+
+    ASSERT_TRUE(reader.prefetch());
+    expect(reader, 100, 50);
+    ASSERT_TRUE(reader.prefetch());
+    ASSERT_EQ(reader.buffered(), (size_t)(206 + 44));
+
+    uint8_t buffer[512];
+    ASSERT_EQ(reader.read(buffer, sizeof(buffer)), 250);
+    ASSERT_TRUE(reader.isFinished());
+    ASSERT_EQ(reader.tell(), (size_t)400);
+    ASSERT_EQ(reader.read(buffer, sizeof(buffer)), (int32_t)lws::Stream::EOS);
+}
+
+TEST_F(FileReaderSuite, PeekingWritesFromTheBuffers) {
+    FileReader reader{ file };
+    reader.readAhead(pool, 256);
+    ASSERT_TRUE(reader.open(0, 0));
+
+    // Nothing's used until it's consumed.
+    uint8_t *ptr = nullptr;
+    ASSERT_EQ(reader.peek(&ptr, 100), 100);
+    ASSERT_EQ(memcmp(ptr, data.data(), 100), 0);
+    ASSERT_EQ(reader.tell(), (size_t)0);
+    reader.consume(40);
+    ASSERT_EQ(reader.tell(), (size_t)40);
+
+    // What's left of the front, then what was prefetched into the back.
+    ASSERT_TRUE(reader.prefetch());
+    ASSERT_EQ(reader.peek(&ptr, 512), 60);
+    ASSERT_EQ(memcmp(ptr, data.data() + 40, 60), 0);
+    reader.consume(60);
+    ASSERT_EQ(reader.peek(&ptr, 512), 256);
+    ASSERT_EQ(memcmp(ptr, data.data() + 100, 256), 0);
+    reader.consume(256);
+    ASSERT_EQ(reader.tell(), (size_t)356);
+
+    // Reads interleave with peeks.
+    expect(reader, 356, 10);
+    ASSERT_EQ(reader.peek(&ptr, 10), 10);
+    ASSERT_EQ(memcmp(ptr, data.data() + 366, 10), 0);
+}
+
+TEST_F(FileReaderSuite, PeekingAtTheEnd) {
+    FileReader reader{ file };
+    reader.readAhead(pool, 256);
+    ASSERT_TRUE(reader.open(1990, 0));
+
+    uint8_t *ptr = nullptr;
+    ASSERT_EQ(reader.peek(&ptr, 256), 10);
+    reader.consume(10);
+    ASSERT_TRUE(reader.isFinished());
+    ASSERT_EQ(reader.peek(&ptr, 256), (int32_t)lws::Stream::EOS);
+}
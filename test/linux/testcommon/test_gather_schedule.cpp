@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+
+#include "gather_schedule.h"
+#include "reading_latency.h"
+
+using namespace fk;
+
+class GatherScheduleSuite : public ::testing::Test {
+protected:
+
+};
+
+struct SimulatedModule {
+    uint8_t address;
+    uint32_t readyAt;
+    uint32_t backoff;
+    uint32_t polls;
+};
+
+/**
+ * Drives the schedule the way GatherReadings does, one transaction on the bus
+ * at a time, each costing transaction milliseconds. Returns the total time.
+ */
+static uint32_t simulate(GatherSchedule<4> &schedule, SimulatedModule *modules, size_t size, uint32_t transaction) {
+    uint32_t now = 0;
+
+    for (size_t i = 0; i < size; ++i) {
+        schedule.add(modules[i].address);
+    }
+
+    while (!schedule.done()) {
+        auto next = schedule.next(now);
+        if (next == nullptr) {
+            now++;
+            continue;
+        }
+
+        SimulatedModule *module = nullptr;
+        for (size_t i = 0; i < size; ++i) {
+            if (modules[i].address == next->address) {
+                module = &modules[i];
+            }
+        }
+
+        now += transaction;
+        module->polls++;
+
+        if (next->stage == GatherStage::Begin) {
+            module->readyAt += now;
+            schedule.poll(module->address, now + module->backoff);
+        }
+        else if (now < module->readyAt) {
+            schedule.poll(module->address, now + module->backoff);
+        }
+        else {
+            schedule.finished(module->address);
+        }
+    }
+
+    return now;
+}
+
+TEST_F(GatherScheduleSuite, SingleModule) {
+    GatherSchedule<4> schedule;
+    SimulatedModule modules[] = {
+        { 8, 1000, 300, 0 },
+    };
+
+    auto elapsed = simulate(schedule, modules, 1, 10);
+
+    ASSERT_GE(elapsed, 1000);
+    ASSERT_LT(elapsed, 1400);
+    ASSERT_TRUE(schedule.done());
+    ASSERT_FALSE(schedule.allFailed());
+}
+
+TEST_F(GatherScheduleSuite, ModulesAreInterleaved) {
+    GatherSchedule<4> schedule;
+    SimulatedModule modules[] = {
+        { 7, 1000, 300, 0 },
+        { 8, 2500, 300, 0 },
+        { 9, 4000, 300, 0 },
+    };
+
+    auto elapsed = simulate(schedule, modules, 3, 10);
+
+    // Bounded by the slowest module, not the sum of all three.
+    ASSERT_GE(elapsed, 4000);
+    ASSERT_LT(elapsed, 4500);
+
+    for (auto &m : modules) {
+        ASSERT_GT(m.polls, 1);
+    }
+}
+
+TEST_F(GatherScheduleSuite, EarliestDueFirst) {
+    GatherSchedule<4> schedule;
+
+    schedule.add(7);
+    schedule.add(8);
+    schedule.poll(7, 500);
+    schedule.poll(8, 200);
+
+    ASSERT_EQ(schedule.next(100), nullptr);
+    ASSERT_EQ(schedule.next(600)->address, 8);
+
+    schedule.finished(8);
+    ASSERT_EQ(schedule.next(600)->address, 7);
+}
+
+TEST_F(GatherScheduleSuite, FailedModules) {
+    GatherSchedule<4> schedule;
+
+    schedule.add(7);
+    schedule.add(8);
+
+    schedule.failed(7);
+    ASSERT_FALSE(schedule.done());
+    ASSERT_FALSE(schedule.allFailed());
+
+    schedule.failed(8);
+    ASSERT_TRUE(schedule.done());
+    ASSERT_TRUE(schedule.allFailed());
+}
+
+TEST_F(GatherScheduleSuite, UnpackedModules) {
+    GatherSchedule<4> schedule;
+
+    schedule.add(7);
+    schedule.add(8);
+    ASSERT_FALSE(schedule.get(7)->unpacked);
+
+    schedule.unpacked(7);
+    ASSERT_TRUE(schedule.get(7)->unpacked);
+    ASSERT_FALSE(schedule.get(8)->unpacked);
+
+    schedule.clear();
+    schedule.add(7);
+    ASSERT_FALSE(schedule.get(7)->unpacked);
+}
+
+TEST_F(GatherScheduleSuite, Capacity) {
+    GatherSchedule<2> schedule;
+
+    ASSERT_TRUE(schedule.add(7));
+    ASSERT_TRUE(schedule.add(8));
+    ASSERT_FALSE(schedule.add(9));
+    ASSERT_EQ(schedule.size(), 2);
+}
+
+TEST_F(GatherScheduleSuite, LatencyPrediction) {
+    ReadingLatencies<4> latencies;
+
+    ASSERT_EQ(latencies.predict(8), 0);
+
+    latencies.observe(8, 0, 1000);
+    latencies.observe(8, 1, 2000);
+    latencies.observe(9, 0, 500);
+
+    ASSERT_EQ(latencies.predict(8), 2000);
+    ASSERT_EQ(latencies.predict(8, 0), 1000);
+    ASSERT_EQ(latencies.predict(9), 500);
+
+    latencies.observe(8, 1, 1000);
+    ASSERT_EQ(latencies.predict(8), 1750);
+}
+
+TEST_F(GatherScheduleSuite, LatencyCapacityAndPolls) {
+    ReadingLatencies<2> latencies;
+
+    latencies.observe(8, 0, 100);
+    latencies.observe(8, 1, 100);
+    latencies.observe(8, 2, 5000);
+    ASSERT_EQ(latencies.predict(8), 100);
+
+    latencies.polled(true);
+    latencies.polled(false);
+    latencies.polled(true);
+    ASSERT_EQ(latencies.polls(), 3);
+    ASSERT_EQ(latencies.wasted(), 2);
+}
+
+TEST_F(GatherScheduleSuite, LatencyPollsArePerGather) {
+    ReadingLatencies<2> latencies;
+
+    latencies.observe(8, 0, 100);
+    latencies.polled(true);
+    latencies.polled(false);
+
+    latencies.beginGather();
+    ASSERT_EQ(latencies.polls(), 0);
+    ASSERT_EQ(latencies.wasted(), 0);
+    ASSERT_EQ(latencies.predict(8), 100);
+
+    latencies.polled(true);
+    ASSERT_EQ(latencies.polls(), 1);
+    ASSERT_EQ(latencies.wasted(), 1);
+}
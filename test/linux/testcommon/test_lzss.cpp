@@ -0,0 +1,181 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "lzss.h"
+#include "lzss_decoder.h"
+
+using namespace fk;
+
+class CollectingOutput : public LzssOutput {
+public:
+    std::vector<uint8_t> data;
+    size_t writes{ 0 };
+    size_t limit{ (size_t)-1 };
+
+public:
+    bool write(const uint8_t *ptr, size_t size) override {
+        if (data.size() + size > limit) {
+            return false;
+        }
+        data.insert(data.end(), ptr, ptr + size);
+        writes++;
+        return true;
+    }
+
+};
+
+class LzssSuite : public ::testing::Test {
+protected:
+    std::vector<uint8_t> compress(const std::vector<uint8_t> &data, size_t piece, CollectingOutput &output) {
+        LzssEncoder encoder;
+        encoder.begin(output);
+        for (size_t i = 0; i < data.size(); i += piece) {
+            auto n = std::min(piece, data.size() - i);
+            EXPECT_TRUE(encoder.write(data.data() + i, n));
+        }
+        EXPECT_TRUE(encoder.finish());
+        EXPECT_EQ(encoder.statistics().in, data.size());
+        EXPECT_EQ(encoder.statistics().out, output.data.size());
+        return output.data;
+    }
+
+    std::vector<uint8_t> decompress(const std::vector<uint8_t> &compressed, size_t piece) {
+        std::vector<uint8_t> decoded;
+        LzssDecoder decoder{ decoded };
+        for (size_t i = 0; i < compressed.size(); i += piece) {
+            auto n = std::min(piece, compressed.size() - i);
+            EXPECT_TRUE(decoder.write(compressed.data() + i, n));
+        }
+        return decoded;
+    }
+
+    /**
+     * Looks like a data file, delimited records that mostly differ in their
+     * reading numbers, times and values.
+     */
+    std::vector<uint8_t> records(size_t number) {
+        std::vector<uint8_t> data;
+        uint32_t seed = 7;
+        for (size_t i = 0; i < number; ++i) {
+            seed = seed * 1103515245 + 12345;
+            uint8_t record[] = {
+                0x16, 0x0a, 0x14, 0x08, 0x01, 0x1a, 0x10, 0x08,
+                (uint8_t)i, 0x10, (uint8_t)(i >> 8), 0x18, 0x02, 0x25,
+                (uint8_t)(seed >> 8), (uint8_t)(seed >> 16), 0x41, 0x42,
+                0x12, 0x04, 0x08, (uint8_t)(seed >> 24), 0x10, 0x00,
+            };
+            data.insert(data.end(), record, record + sizeof(record));
+        }
+        return data;
+    }
+
+};
+
+TEST_F(LzssSuite, Empty) {
+    CollectingOutput output;
+    auto compressed = compress({ }, 1, output);
+
+    ASSERT_EQ(compressed.size(), (size_t)0);
+    ASSERT_EQ(decompress(compressed, 1).size(), (size_t)0);
+}
+
+TEST_F(LzssSuite, ShortLiterals) {
+    std::vector<uint8_t> data = { 'a', 'b' };
+
+    CollectingOutput output;
+    auto compressed = compress(data, 1, output);
+
+    ASSERT_EQ(compressed.size(), (size_t)3);
+    ASSERT_EQ(compressed[0], 0x03);
+    ASSERT_EQ(decompress(compressed, 1), data);
+}
+
+TEST_F(LzssSuite, RunsOverlapTheirReferences) {
+    std::vector<uint8_t> data(4096, 0xff);
+
+    CollectingOutput output;
+    auto compressed = compress(data, 512, output);
+
+    ASSERT_LT(compressed.size(), (size_t)200);
+    ASSERT_EQ(decompress(compressed, 7), data);
+}
+
+TEST_F(LzssSuite, RecordsRoundTripInAnyPieces) {
+    auto data = records(1000);
+
+    for (auto piece : { (size_t)1, (size_t)13, (size_t)512, (size_t)4096 }) {
+        CollectingOutput output;
+        auto compressed = compress(data, piece, output);
+
+        ASSERT_LT(compressed.size(), data.size() * 3 / 4);
+        ASSERT_EQ(decompress(compressed, 1), data);
+        ASSERT_EQ(decompress(compressed, 1000), data);
+    }
+}
+
+TEST_F(LzssSuite, RandomDataGrowsByTheFlags) {
+    std::vector<uint8_t> data(64 * 1024);
+    uint32_t seed = 1;
+    for (auto &byte : data) {
+        seed = seed * 1103515245 + 12345;
+        byte = (uint8_t)(seed >> 16);
+    }
+
+    CollectingOutput output;
+    auto compressed = compress(data, 1000, output);
+
+    ASSERT_LE(compressed.size(), data.size() + (data.size() + 7) / 8);
+    ASSERT_EQ(decompress(compressed, 333), data);
+}
+
+TEST_F(LzssSuite, ReferencesStayInsideTheWindow) {
+    // Repeats further apart than the window can't be matched, closer ones
+    // can.
+    for (auto period : { LzssWindowSize, (size_t)64 }) {
+        std::vector<uint8_t> block(period);
+        uint32_t seed = 3;
+        for (auto &byte : block) {
+            seed = seed * 1103515245 + 12345;
+            byte = (uint8_t)(seed >> 16);
+        }
+
+        std::vector<uint8_t> data;
+        while (data.size() < 8 * LzssWindowSize) {
+            data.insert(data.end(), block.begin(), block.end());
+        }
+
+        CollectingOutput output;
+        auto compressed = compress(data, 100, output);
+
+        if (period > LzssMaximumDistance) {
+            ASSERT_GT(compressed.size(), data.size());
+        }
+        else {
+            ASSERT_LT(compressed.size(), data.size() / 8);
+        }
+        ASSERT_EQ(decompress(compressed, 64), data);
+    }
+}
+
+TEST_F(LzssSuite, OutputFailuresAreSticky) {
+    auto data = records(100);
+
+    CollectingOutput output;
+    output.limit = 64;
+
+    LzssEncoder encoder;
+    encoder.begin(output);
+    ASSERT_FALSE(encoder.write(data.data(), data.size()));
+    ASSERT_FALSE(encoder.finish());
+    ASSERT_LE(output.data.size(), (size_t)64);
+}
+
+TEST_F(LzssSuite, DecoderRejectsReferencesBeforeTheBeginning) {
+    std::vector<uint8_t> compressed = { 0x00, 0x00, 0x40 };
+    std::vector<uint8_t> decoded;
+    LzssDecoder decoder{ decoded };
+
+    ASSERT_FALSE(decoder.write(compressed.data(), compressed.size()));
+    ASSERT_TRUE(decoder.failed());
+}
@@ -0,0 +1,126 @@
+#include <cmath>
+#include <gtest/gtest.h>
+
+#include "reading_block.h"
+#include "reading_block_decoder.h"
+
+using namespace fk;
+
+class ReadingBlockSuite : public ::testing::Test {
+protected:
+
+};
+
+TEST_F(ReadingBlockSuite, RoundTrip) {
+    BlockReading readings[] = {
+        { 2, 1500000002, 1024.5f },
+        { 0, 1500000000, 21.125f },
+        { 1, 1500000001, -3.75f },
+    };
+
+    uint8_t buffer[256];
+    ReadingBlockEncoder encoder{ 3 };
+    auto size = encoder.encode(buffer, sizeof(buffer), 42, readings, 3);
+    ASSERT_GT(size, 0);
+
+    std::vector<DecodedReading> decoded;
+    ReadingBlockDecoder decoder;
+    ASSERT_TRUE(decoder.decodeFile(buffer, size, decoded));
+    ASSERT_EQ(decoder.records(), 1);
+    ASSERT_EQ(decoder.blocks(), 1);
+    ASSERT_EQ(decoded.size(), 3);
+
+    ASSERT_EQ(decoded[0].reading, 42);
+    ASSERT_EQ(decoded[0].sensor, 0);
+    ASSERT_EQ(decoded[0].time, 1500000000);
+    ASSERT_FLOAT_EQ(decoded[0].value, 21.125f);
+
+    ASSERT_EQ(decoded[1].sensor, 1);
+    ASSERT_EQ(decoded[1].time, 1500000001);
+    ASSERT_FLOAT_EQ(decoded[1].value, -3.75f);
+
+    ASSERT_EQ(decoded[2].sensor, 2);
+    ASSERT_EQ(decoded[2].time, 1500000002);
+    ASSERT_FLOAT_EQ(decoded[2].value, 1024.5f);
+}
+
+TEST_F(ReadingBlockSuite, Quantized) {
+    BlockReading readings[] = {
+        { 0, 1500000000, 3.14159265f },
+        { 9, 1500000000, 7.0f },
+    };
+
+    uint8_t buffer[256];
+    ReadingBlockEncoder encoder{ 2 };
+    auto size = encoder.encode(buffer, sizeof(buffer), 1, readings, 2);
+    ASSERT_GT(size, 0);
+
+    std::vector<DecodedReading> decoded;
+    ReadingBlockDecoder decoder;
+    ASSERT_TRUE(decoder.decodeFile(buffer, size, decoded));
+    ASSERT_EQ(decoded.size(), 2);
+    ASSERT_NEAR(decoded[0].value, 3.14f, 0.0001f);
+    ASSERT_EQ(decoded[1].sensor, 9);
+    ASSERT_FLOAT_EQ(decoded[1].value, 7.0f);
+}
+
+TEST_F(ReadingBlockSuite, LargeAndNonFiniteValues) {
+    BlockReading readings[] = {
+        { 0, 1500000000, 3.0e9f },
+        { 1, 1500000000, NAN },
+        { 2, 1500000000, 123456.0f },
+    };
+
+    uint8_t buffer[256];
+    ReadingBlockEncoder encoder{ 7 };
+    auto size = encoder.encode(buffer, sizeof(buffer), 1, readings, 3);
+    ASSERT_GT(size, 0);
+
+    std::vector<DecodedReading> decoded;
+    ReadingBlockDecoder decoder;
+    ASSERT_TRUE(decoder.decodeFile(buffer, size, decoded));
+    ASSERT_EQ(decoded.size(), 3);
+    ASSERT_FLOAT_EQ(decoded[0].value, 3.0e9f);
+    ASSERT_TRUE(std::isnan(decoded[1].value));
+    ASSERT_FLOAT_EQ(decoded[2].value, 123456.0f);
+}
+
+TEST_F(ReadingBlockSuite, SkipsOtherRecords) {
+    // A delimited record with a varint field and a string field, much like a
+    // status or log record.
+    uint8_t buffer[256] = { 7, 0x08, 0x96, 0x01, 0x12, 0x02, 'h', 'i' };
+    size_t position = 8;
+
+    BlockReading readings[] = {
+        { 4, 1500000000, 1.0f },
+    };
+
+    ReadingBlockEncoder encoder{ 3 };
+    position += encoder.encode(buffer + position, sizeof(buffer) - position, 7, readings, 1);
+
+    std::vector<DecodedReading> decoded;
+    ReadingBlockDecoder decoder;
+    ASSERT_TRUE(decoder.decodeFile(buffer, position, decoded));
+    ASSERT_EQ(decoder.records(), 2);
+    ASSERT_EQ(decoder.blocks(), 1);
+    ASSERT_EQ(decoded.size(), 1);
+    ASSERT_EQ(decoded[0].sensor, 4);
+}
+
+TEST_F(ReadingBlockSuite, Failures) {
+    uint8_t buffer[256];
+    ReadingBlockEncoder encoder{ 3 };
+
+    BlockReading duplicated[] = {
+        { 1, 1500000000, 1.0f },
+        { 1, 1500000000, 2.0f },
+    };
+    ASSERT_EQ(encoder.encode(buffer, sizeof(buffer), 1, duplicated, 2), 0);
+
+    BlockReading readings[] = {
+        { 1, 1500000000, 1.0f },
+        { 2, 1500000000, 2.0f },
+    };
+    ASSERT_EQ(encoder.encode(buffer, 16, 1, readings, 2), 0);
+    ASSERT_EQ(encoder.encode(buffer, sizeof(buffer), 1, readings, 0), 0);
+}
@@ -0,0 +1,134 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "record_frame.h"
+
+using namespace fk;
+
+class CollectingVisitor : public RecordFrameVisitor {
+public:
+    std::vector<std::vector<uint8_t>> records;
+
+public:
+    void record(const uint8_t *record, size_t size) override {
+        records.emplace_back(record, record + size);
+    }
+
+};
+
+class RecordFrameSuite : public ::testing::Test {
+protected:
+    std::vector<uint8_t> file;
+
+    void append(uint8_t value, size_t size) {
+        std::vector<uint8_t> record(size, value);
+        record[0] = (uint8_t)(size - 1);
+
+        uint8_t header[RecordFrameHeaderSize];
+        record_frame_header(header, record.data(), record.size());
+
+        file.insert(file.end(), header, header + sizeof(header));
+        file.insert(file.end(), record.begin(), record.end());
+    }
+
+};
+
+TEST_F(RecordFrameSuite, FramesAreDelimitedRecords) {
+    append(0x11, 20);
+
+    // Delimiter, tag for field 1002 and the field's length.
+    ASSERT_EQ(file[0], RecordFrameHeaderSize - 1);
+    ASSERT_EQ(file[1], 0xd2);
+    ASSERT_EQ(file[2], 0x3e);
+    ASSERT_EQ(file[3], 12);
+}
+
+TEST_F(RecordFrameSuite, VerifiesInAnySizedChunks) {
+    append(0x11, 20);
+    append(0x22, 100);
+    append(0x33, 7);
+
+    for (auto chunk : { (size_t)1, (size_t)5, (size_t)16, (size_t)1000 }) {
+        CollectingVisitor visitor;
+        RecordFrameVerifier<256> verifier{ visitor };
+
+        for (size_t i = 0; i < file.size(); i += chunk) {
+            auto n = std::min(chunk, file.size() - i);
+            verifier.write(file.data() + i, n);
+        }
+        verifier.finish();
+
+        ASSERT_EQ(visitor.records.size(), 3);
+        ASSERT_EQ(visitor.records[1].size(), 100);
+        ASSERT_EQ(visitor.records[1][50], 0x22);
+        ASSERT_EQ(verifier.statistics().good, 3);
+        ASSERT_EQ(verifier.statistics().bad, 0);
+        ASSERT_EQ(verifier.statistics().skipped, 0);
+    }
+}
+
+TEST_F(RecordFrameSuite, CorruptRecordIsSkipped) {
+    append(0x11, 20);
+    append(0x22, 100);
+    append(0x33, 7);
+
+    file[RecordFrameHeaderSize + 20 + RecordFrameHeaderSize + 40] ^= 0x01;
+
+    CollectingVisitor visitor;
+    RecordFrameVerifier<256> verifier{ visitor };
+    verifier.write(file.data(), file.size());
+    verifier.finish();
+
+    ASSERT_EQ(visitor.records.size(), 2);
+    ASSERT_EQ(visitor.records[0][1], 0x11);
+    ASSERT_EQ(visitor.records[1][1], 0x33);
+    ASSERT_EQ(verifier.statistics().bad, 1);
+}
+
+TEST_F(RecordFrameSuite, CorruptSizeResyncs) {
+    append(0x11, 20);
+    append(0x22, 100);
+    append(0x33, 7);
+
+    // A huge size would otherwise swallow everything after it.
+    file[RecordFrameHeaderSize + 20 + 10] = 0xff;
+
+    CollectingVisitor visitor;
+    RecordFrameVerifier<256> verifier{ visitor };
+    verifier.write(file.data(), file.size());
+    verifier.finish();
+
+    ASSERT_EQ(visitor.records.size(), 2);
+    ASSERT_EQ(visitor.records[1][1], 0x33);
+    ASSERT_EQ(verifier.statistics().bad, 1);
+}
+
+TEST_F(RecordFrameSuite, GarbageBetweenFramesIsSkipped) {
+    append(0x11, 20);
+    file.insert(file.end(), { 0x0f, 0xd2, 0x00, 0x01, 0x02 });
+    append(0x22, 30);
+
+    CollectingVisitor visitor;
+    RecordFrameVerifier<256> verifier{ visitor };
+    verifier.write(file.data(), file.size());
+    verifier.finish();
+
+    ASSERT_EQ(visitor.records.size(), 2);
+    ASSERT_EQ(verifier.statistics().skipped, 5);
+    ASSERT_EQ(verifier.statistics().bad, 0);
+}
+
+TEST_F(RecordFrameSuite, TruncatedFrameAtEnd) {
+    append(0x11, 20);
+    append(0x22, 30);
+    file.resize(file.size() - 10);
+
+    CollectingVisitor visitor;
+    RecordFrameVerifier<256> verifier{ visitor };
+    verifier.write(file.data(), file.size());
+    verifier.finish();
+
+    ASSERT_EQ(visitor.records.size(), 1);
+    ASSERT_EQ(verifier.statistics().bad, 1);
+}
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include "running_statistics.h"
+
+using namespace fk;
+
+class RunningStatisticsSuite : public ::testing::Test {
+protected:
+
+};
+
+TEST_F(RunningStatisticsSuite, Empty) {
+    RunningStatistics statistics;
+
+    ASSERT_EQ(statistics.count(), 0);
+    ASSERT_FLOAT_EQ(statistics.mean(), 0.0f);
+    ASSERT_FLOAT_EQ(statistics.variance(), 0.0f);
+}
+
+TEST_F(RunningStatisticsSuite, Basic) {
+    RunningStatistics statistics;
+
+    float samples[] = { 2.0f, 4.0f, 4.0f, 4.0f, 5.0f, 5.0f, 7.0f, 9.0f };
+    for (auto s : samples) {
+        statistics.add(s);
+    }
+
+    ASSERT_EQ(statistics.count(), 8);
+    ASSERT_FLOAT_EQ(statistics.mean(), 5.0f);
+    ASSERT_FLOAT_EQ(statistics.min(), 2.0f);
+    ASSERT_FLOAT_EQ(statistics.max(), 9.0f);
+    ASSERT_NEAR(statistics.variance(), 32.0f / 7.0f, 0.0001f);
+    ASSERT_NEAR(statistics.stddev(), 2.13809f, 0.0001f);
+}
+
+TEST_F(RunningStatisticsSuite, NegativeAndClear) {
+    RunningStatistics statistics;
+
+    statistics.add(-3.0f);
+    statistics.add(-1.0f);
+    ASSERT_FLOAT_EQ(statistics.min(), -3.0f);
+    ASSERT_FLOAT_EQ(statistics.max(), -1.0f);
+    ASSERT_FLOAT_EQ(statistics.mean(), -2.0f);
+
+    statistics.clear();
+    statistics.add(10.0f);
+    ASSERT_EQ(statistics.count(), 1);
+    ASSERT_FLOAT_EQ(statistics.min(), 10.0f);
+    ASSERT_FLOAT_EQ(statistics.max(), 10.0f);
+    ASSERT_FLOAT_EQ(statistics.variance(), 0.0f);
+}
@@ -0,0 +1,194 @@
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "socket_buffer.h"
+#include "tuning.h"
+
+using namespace fk;
+
+class FakeClient : public SocketOutput {
+public:
+    std::string data;
+    std::vector<size_t> sends;
+    bool open{ true };
+    size_t limit{ (size_t)-1 };
+
+public:
+    bool connected() override {
+        return open;
+    }
+
+    size_t write(const uint8_t *ptr, size_t size) override {
+        auto n = data.size() + size > limit ? limit - data.size() : size;
+        data.append((const char *)ptr, n);
+        sends.push_back(size);
+        return n;
+    }
+
+};
+
+class SocketBufferSuite : public ::testing::Test {
+protected:
+    uint8_t memory[WifiSocketBufferSize];
+    SocketBuffer buffer;
+    FakeClient client;
+
+protected:
+    void SetUp() override {
+        buffer.begin(client, memory, sizeof(memory));
+    }
+
+    bool write(const std::string &s) {
+        return buffer.write((const uint8_t *)s.data(), s.size());
+    }
+
+    /**
+     * Undoes the chunked transfer coding, failing if it's malformed or there
+     * is anything after the last chunk.
+     */
+    std::string dechunk(const std::string &body, std::vector<size_t> &sizes) {
+        std::string decoded;
+        size_t i = 0;
+        while (true) {
+            auto eol = body.find("\r\n", i);
+            EXPECT_NE(eol, std::string::npos);
+            if (eol == std::string::npos) {
+                return decoded;
+            }
+            auto length = (size_t)std::stoul(body.substr(i, eol - i), nullptr, 16);
+            i = eol + 2;
+            sizes.push_back(length);
+            decoded += body.substr(i, length);
+            i += length;
+            EXPECT_EQ(body.substr(i, 2), "\r\n");
+            i += 2;
+            if (length == 0) {
+                EXPECT_EQ(i, body.size());
+                return decoded;
+            }
+        }
+    }
+
+    std::string pattern(size_t size) {
+        std::string s;
+        for (size_t i = 0; i < size; ++i) {
+            s += (char)('a' + (i % 26));
+        }
+        return s;
+    }
+
+};
+
+TEST_F(SocketBufferSuite, SmallWritesWaitForFlush) {
+    ASSERT_TRUE(write("GET / HTTP/1.1\r\n"));
+    ASSERT_TRUE(write("\r\n"));
+    ASSERT_EQ(client.sends.size(), (size_t)0);
+
+    ASSERT_TRUE(buffer.flush());
+    ASSERT_EQ(client.data, "GET / HTTP/1.1\r\n\r\n");
+    ASSERT_EQ(client.sends.size(), (size_t)1);
+    ASSERT_EQ(buffer.statistics().partial, (uint32_t)1);
+
+    ASSERT_TRUE(buffer.flush());
+    ASSERT_EQ(client.sends.size(), (size_t)1);
+}
+
+TEST_F(SocketBufferSuite, WholeBuffersAreSentAsTheyFill) {
+    auto data = pattern(WifiSocketBufferSize * 2 + 100);
+    for (size_t i = 0; i < data.size(); i += 100) {
+        ASSERT_TRUE(write(data.substr(i, 100)));
+    }
+    ASSERT_EQ(client.sends.size(), (size_t)2);
+    ASSERT_EQ(client.sends[0], WifiSocketBufferSize);
+    ASSERT_EQ(client.sends[1], WifiSocketBufferSize);
+
+    ASSERT_TRUE(buffer.flush());
+    ASSERT_EQ(client.data, data);
+    ASSERT_EQ(buffer.statistics().bytes, data.size());
+    ASSERT_EQ(buffer.statistics().segments, (uint32_t)3);
+    ASSERT_EQ(buffer.statistics().partial, (uint32_t)1);
+}
+
+TEST_F(SocketBufferSuite, LargeWritesSkipTheBuffer) {
+    auto data = pattern(WifiSocketBufferSize * 2 + 10);
+    ASSERT_TRUE(write(data));
+    ASSERT_EQ(client.sends.size(), (size_t)2);
+    ASSERT_TRUE(buffer.flush());
+    ASSERT_EQ(client.data, data);
+}
+
+TEST_F(SocketBufferSuite, ChunksFitInOneSend) {
+    ASSERT_TRUE(write("POST / HTTP/1.1\r\n\r\n"));
+    ASSERT_TRUE(buffer.beginChunks());
+    ASSERT_EQ(client.data, "POST / HTTP/1.1\r\n\r\n");
+    client.data.clear();
+    client.sends.clear();
+
+    auto data = pattern(WifiSocketBufferSize * 3);
+    for (size_t i = 0; i < data.size(); i += 333) {
+        ASSERT_TRUE(write(data.substr(i, 333)));
+    }
+    ASSERT_TRUE(buffer.finishChunks());
+
+    // Every full chunk is the buffer, header and trailer included.
+    ASSERT_GE(client.sends.size(), (size_t)4);
+    for (size_t i = 0; i < client.sends.size() - 2; ++i) {
+        ASSERT_EQ(client.sends[i], WifiSocketBufferSize);
+    }
+
+    std::vector<size_t> sizes;
+    ASSERT_EQ(dechunk(client.data, sizes), data);
+    ASSERT_EQ(sizes.front(), WifiSocketBufferSize - 5 - 2);
+    ASSERT_LE(sizes.front(), (size_t)0xfff);
+    ASSERT_EQ(sizes.back(), (size_t)0);
+}
+
+TEST_F(SocketBufferSuite, ChunkSizesAreThreeHexDigits) {
+    ASSERT_TRUE(buffer.beginChunks());
+    ASSERT_TRUE(write(pattern(10)));
+    ASSERT_TRUE(buffer.flush());
+    ASSERT_TRUE(write(pattern(0x1ab)));
+    ASSERT_TRUE(buffer.finishChunks());
+
+    auto expected = "00a\r\n" + pattern(10) + "\r\n" + "1ab\r\n" + pattern(0x1ab) + "\r\n" + "0\r\n\r\n";
+    ASSERT_EQ(client.data, expected);
+}
+
+TEST_F(SocketBufferSuite, FinishingWithNothingWaiting) {
+    ASSERT_TRUE(buffer.beginChunks());
+    ASSERT_TRUE(buffer.finishChunks());
+    ASSERT_EQ(client.data, "0\r\n\r\n");
+
+    // Back to plain writes afterwards.
+    ASSERT_TRUE(write("done"));
+    ASSERT_TRUE(buffer.flush());
+    ASSERT_EQ(client.data, "0\r\n\r\ndone");
+}
+
+TEST_F(SocketBufferSuite, ShortSendsFail) {
+    client.limit = 100;
+    ASSERT_FALSE(write(pattern(WifiSocketBufferSize)));
+    ASSERT_EQ(buffer.statistics().bytes, (uint32_t)100);
+}
+
+TEST_F(SocketBufferSuite, DisconnectedFails) {
+    client.open = false;
+    ASSERT_FALSE(write("hello"));
+    ASSERT_EQ(client.sends.size(), (size_t)0);
+}
+
+TEST_F(SocketBufferSuite, ChunksAreLimitedToThreeDigits) {
+    std::vector<uint8_t> large(0x1800);
+    buffer.begin(client, large.data(), large.size());
+
+    auto data = pattern(0x2000);
+    ASSERT_TRUE(buffer.beginChunks());
+    ASSERT_TRUE(write(data));
+    ASSERT_TRUE(buffer.finishChunks());
+
+    std::vector<size_t> sizes;
+    ASSERT_EQ(dechunk(client.data, sizes), data);
+    ASSERT_EQ(sizes.front(), (size_t)0xfff);
+}